@@ -11,6 +11,7 @@
 #include "a_types.h"
 #include "a_info.h"
 #include "cardinal.h"
+#include "coord.h"
 #include "mylib/array.h"
 #include "mylib/mathlib.h"
 #include "mylib/sprite.h"
@@ -55,6 +56,15 @@ typedef struct control_state control_state_t;
 typedef void (* update_func_t)(actor_t *, float);
 typedef void (* contact_func_t)(actor_t *, actor_t *);
 
+/// Refers to an actor for as long as it exists. Pointers into and indices
+/// of `world->actors` change whenever actors are added or removed.
+typedef struct {
+    int slot; // Index into world->actor_slots, or -1.
+    int generation;
+} actor_handle_t;
+
+#define NULL_ACTOR_HANDLE ((actor_handle_t){ -1, 0 })
+
 struct actor {
     actor_type_t type;
 
@@ -99,6 +109,12 @@ struct actor {
     // Actors may change the world, so keep an internal reference.
     world_t * world;
 
+    // The chunk bucket this actor is listed in (see w_update.c).
+    chunk_coord_t bucket;
+
+    // Set when the actor is added to world->actors.
+    actor_handle_t handle;
+
     void (* draw)(actor_t * self, int x, int y);
 };
 
@@ -118,7 +134,25 @@ struct actor_state {
 // a_main.c
 
 void ChangeActorState(actor_t * actor, actor_state_t * new_state);
+
+/// Make an actor of `type` at `position`, without adding it to the world.
+actor_t NewActor(actor_type_t type, vec2_t position, world_t * world);
+
 actor_t * SpawnActor(actor_type_t type, vec2_t position, world_t * world);
+
+/// Add a copy of `actor` to `world->actors` and give it a handle.
+actor_t * AddActor(world_t * world, const actor_t * actor);
+
+/// Add copies of `count` actors to `world->actors` and give them handles.
+/// Returns the first.
+actor_t * AddActors(world_t * world, const actor_t * actors, int count);
+
+/// Remove the actor at `index` in `world->actors` and invalidate its handle.
+/// The last actor is moved into its place.
+void RemoveActor(world_t * world, int index);
+
+/// The actor `handle` refers to, or NULL if it has been removed.
+actor_t * GetActor(world_t * world, actor_handle_t handle);
 sprite_t * GetActorSprite(const actor_t * actor);
 void DamageActor(actor_t * attacker, actor_t * target);
 void UpdateActor(actor_t * actor, float dt);
@@ -129,11 +163,26 @@ SDL_Rect GetActorVisibleRect(const actor_t * actor);
 /// Actor's hitbox in world pixel space.
 SDL_FRect ActorHitbox(const actor_t * actor);
 
+/// Clip `actor` against any of `blocks` it overlaps, along one axis.
+/// `blocks` should be in actor array order.
 void DoCollisions(bool vertical, actor_t * actor, actor_t ** blocks, int num_blocks);
 
+/// Whether an actor never moves: it has no state or update function.
+bool ActorIsStatic(const actor_t * actor);
+
+/// The render layer (`render_layer_t`) an actor is drawn in: items go under
+/// everything else, other actors are layered by their sprite's `draw_order`.
+u8 ActorLayer(const actor_t * actor);
+
+/// Queue an actor's sprite, lit by the actor's lighting. Drawn at the next
+/// `FlushSprites()`.
 void DrawActorSprite(actor_t * actor, sprite_t * sprite, int x, int y);
+
+/// Queue an actor. Drawn at the next `FlushSprites()`.
 void DrawActor(actor_t * actor, SDL_Rect visible_rect);
 
+void DrawActorHitbox(actor_t * actor, SDL_Rect visible_rect);
+
 const char * ActorName(actor_type_t type);
 actor_t * GetActorType(array_t * array, actor_type_t type);
 
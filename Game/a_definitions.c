@@ -403,14 +403,17 @@ void DrawPlayer(actor_t * player, int x, int y)
         ret_pos.x -= (spr->location.w * DRAW_SCALE) / 2.0f;
         ret_pos.y -= (spr->location.h * DRAW_SCALE) / 2.0f;
 
-        DrawSprite
+        QueueSprite
         (   spr,
             0,
             0,
             ret_pos.x - visible_rect.x,
             ret_pos.y - visible_rect.y,
             DRAW_SCALE,
-            0 );
+            0,
+            player->lighting,
+            LAYER_ACTORS,
+            player->pos.y );
     }
 
     DrawActorSprite(player, GetActorSprite(player), x, y);
@@ -8,10 +8,74 @@
 #include "a_actor.h"
 #include "m_debug.h"
 #include "m_misc.h"
+#include "sprites.h"
 #include "w_world.h"
 #include "mylib/genlib.h"
 #include "mylib/video.h"
 
+actor_t * AddActors(world_t * world, const actor_t * actors, int count)
+{
+    int first = world->actors->count;
+    actor_t * added = AppendMany(world->actors, (actor_t *)actors, count);
+
+    for ( int i = 0; i < count; i++ ) {
+        actor_slot_t * slot;
+        int slot_index = world->free_actor_slot;
+
+        if ( slot_index != -1 ) {
+            slot = GetElement(world->actor_slots, slot_index);
+            world->free_actor_slot = slot->index;
+        } else {
+            actor_slot_t new_slot = { 0 };
+            slot = Append(world->actor_slots, &new_slot);
+            slot_index = world->actor_slots->count - 1;
+        }
+
+        slot->index = first + i;
+        added[i].handle = (actor_handle_t){ slot_index, slot->generation };
+    }
+
+    ActorsAppended(world, count);
+
+    return added;
+}
+
+actor_t * AddActor(world_t * world, const actor_t * actor)
+{
+    return AddActors(world, actor, 1);
+}
+
+void RemoveActor(world_t * world, int index)
+{
+    actor_t * actor = GetElement(world->actors, index);
+    actor_slot_t * slot = GetElement(world->actor_slots, actor->handle.slot);
+
+    slot->generation++;
+    slot->index = world->free_actor_slot;
+    world->free_actor_slot = actor->handle.slot;
+
+    ActorRemoving(world, index);
+    FastRemove(world->actors, index);
+
+    // Point the slot of the actor that was moved into place at its new index.
+    if ( index < world->actors->count ) {
+        actor_t * moved = GetElement(world->actors, index);
+        actor_slot_t * moved_slot = GetElement(world->actor_slots, moved->handle.slot);
+        moved_slot->index = index;
+    }
+}
+
+actor_t * GetActor(world_t * world, actor_handle_t handle)
+{
+    actor_slot_t * slot = GetElement(world->actor_slots, handle.slot);
+
+    if ( slot == NULL || slot->generation != handle.generation ) {
+        return NULL;
+    }
+
+    return GetElement(world->actors, slot->index);
+}
+
 sprite_t * GetActorSprite(const actor_t * actor)
 {
     if ( actor->state != NULL ) {
@@ -21,7 +85,7 @@ sprite_t * GetActorSprite(const actor_t * actor)
     }
 }
 
-actor_t * SpawnActor(actor_type_t type, vec2_t position, world_t * world)
+actor_t NewActor(actor_type_t type, vec2_t position, world_t * world)
 {
     actor_t actor = GetActorDefinition(type);
     actor.type = type;
@@ -56,9 +120,17 @@ actor_t * SpawnActor(actor_type_t type, vec2_t position, world_t * world)
             break;
     }
 
+    return actor;
+}
+
+actor_t * SpawnActor(actor_type_t type, vec2_t position, world_t * world)
+{
+    actor_t actor = NewActor(type, position, world);
+
     if ( !world->updating_actors ) {
-        return Append(world->actors, &actor);
+        return AddActor(world, &actor);
     } else {
+        actor.handle = NULL_ACTOR_HANDLE;
         return Append(world->pending_actors, &actor);
     }
 }
@@ -257,9 +329,24 @@ void DoCollisions(bool vertical, actor_t * actor, actor_t ** blocks, int num_blo
     }
 }
 
+bool ActorIsStatic(const actor_t * actor)
+{
+    return actor->state == NULL && actor->update == NULL;
+}
+
+u8 ActorLayer(const actor_t * actor)
+{
+    if ( actor->flags & ACTOR_FLAG_COLLETIBLE ) {
+        return LAYER_ITEMS;
+    }
+
+    sprite_t * sprite = GetActorSprite(actor);
+    return LAYER_ACTORS + (sprite ? sprite->draw_order : 0);
+}
+
 void DrawActorSprite(actor_t * actor, sprite_t * sprite, int x, int y)
 {
-    DrawSprite
+    QueueSprite
     (   sprite,
         actor->current_frame,
         actor->flags & ACTOR_FLAG_DIRECTIONAL
@@ -268,7 +355,10 @@ void DrawActorSprite(actor_t * actor, sprite_t * sprite, int x, int y)
         x,
         y,
         DRAW_SCALE,
-        0 ); // TODO: actor flippable?
+        0, // TODO: actor flippable?
+        actor->lighting,
+        ActorLayer(actor),
+        actor->pos.y );
 }
 
 void DrawActor(actor_t * actor, SDL_Rect visible_rect)
@@ -280,25 +370,24 @@ void DrawActor(actor_t * actor, SDL_Rect visible_rect)
         r.x -= visible_rect.x; // convert to window space
         r.y -= visible_rect.y;
 
-        SetSpriteColorMod(sprite, actor->lighting);
-
         if ( actor->draw ) {
             actor->draw(actor, r.x, r.y);
         } else {
             DrawActorSprite(actor, sprite, r.x, r.y);
         }
-
-        if ( show_geometry ) {
-            SDL_FRect hitbox = ActorHitbox(actor);
-            V_SetRGBA(90, 90, 255, 255);
-            hitbox.x -= visible_rect.x;
-            hitbox.y -= visible_rect.y;
-            SDL_Rect hitbox_i = { hitbox.x, hitbox.y, hitbox.w, hitbox.h };
-            V_DrawRect(&hitbox_i);
-        }
     }
 }
 
+void DrawActorHitbox(actor_t * actor, SDL_Rect visible_rect)
+{
+    SDL_FRect hitbox = ActorHitbox(actor);
+    V_SetRGBA(90, 90, 255, 255);
+    hitbox.x -= visible_rect.x;
+    hitbox.y -= visible_rect.y;
+    SDL_Rect hitbox_i = { hitbox.x, hitbox.y, hitbox.w, hitbox.h };
+    V_DrawRect(&hitbox_i);
+}
+
 const char * ActorName(actor_type_t type)
 {
     switch ( type ) {
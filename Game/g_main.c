@@ -9,10 +9,12 @@
 
 #include "w_world.h"
 #include "m_debug.h"
+#include "sprites.h"
 
 #include "mylib/genlib.h"
 #include "mylib/video.h"
 #include "mylib/texture.h"
+#include "mylib/array.h"
 #include "mylib/input.h"
 
 #include <SDL.h>
@@ -76,13 +78,17 @@ static void G_DoFrame(game_t * game, input_state_t * input, float dt )
         game->controls_processed = G_ProcessControl(game);
     }
 
+    int allocations_start = array_allocations; // debug
     if ( !game->paused ) {
         G_Update(game, dt);
     }
 
+    int lookups_start = texture_lookups; // debug
     V_ClearRGB(0, 0, 0);
     G_Render(game);
     UI_Render(game);
+    frame_texture_lookups = texture_lookups - lookups_start; // debug
+    frame_array_allocations = array_allocations - allocations_start; // debug
 
     DisplayDebugInfo(game->world, IN_GetMousePosition(input));
     V_Refresh();
@@ -142,6 +148,7 @@ void G_Main(void)
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
     V_SetFont(FONT_CP437_8X8);
     V_SetTextScale(DRAW_SCALE, DRAW_SCALE);
+    ResolveSprites(sprites, NUM_SPRITES);
 
     //SDL_ShowCursor(SDL_DISABLE);
 
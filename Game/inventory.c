@@ -15,7 +15,7 @@
 
 inventory_t * INV_GetInventory(game_t * game)
 {
-    actor_t * player = GetActorType(game->world->actors, ACTOR_PLAYER);
+    actor_t * player = GetActor(game->world, game->world->player);
     return player->info.player.inventory;
 }
 
@@ -23,9 +23,18 @@ int debug_minutes;
 
 vec2_t mouse_tile;
 
+// Chunks that were / weren't loaded by the time they came into view.
+int prefetch_hits;
+int prefetch_misses;
+
+int chunk_workers; // Number of chunk worker threads running.
+
 int frame;
 int frame_ms;
 int render_ms;
+int render_draw_calls;
+int frame_texture_lookups;
+int frame_array_allocations;
 int update_ms;
 float debug_dt;
 
@@ -47,7 +56,12 @@ void DisplayGeneralInfo(world_t * world)
 
     V_PrintString(0, row++ * h, "Frame time: %2d ms", frame_ms);
     V_PrintString(0, row++ * h, "- Render time: %2d ms", render_ms);
+    V_PrintString(0, row++ * h, "  (%d draw calls, %d texture lookups)",
+          render_draw_calls,
+          frame_texture_lookups);
     V_PrintString(0, row++ * h, "- Update time: %2d ms", update_ms);
+    V_PrintString(0, row++ * h, "  (%d array allocations this frame)",
+          frame_array_allocations);
     V_PrintString(0, row++ * h, "- dt: %.3f sec", debug_dt);
     V_PrintString(0, row++ * h, "Camera Tile: %.2f, %.2f",
           world->camera.x / SCALED_TILE_SIZE,
@@ -56,6 +70,15 @@ void DisplayGeneralInfo(world_t * world)
           debug_hours > 12 ? debug_hours - 12 : debug_hours,
           debug_minutes,
           debug_hours < 12 ? "AM" : "PM" );
+
+    terrain_cache_stats_t * terrain = &world->terrain_stats;
+    V_PrintString(0, row++ * h, "Terrain cache: %zu KB%s",
+          terrain->resident_bytes / 1024,
+          grass_effect_variants ? " (effect variants)" : "");
+    V_PrintString(0, row++ * h, "- %d hits, %d misses, %d evictions",
+          terrain->hits,
+          terrain->misses,
+          terrain->evictions);
 }
 
 void DisplayTileInfo(world_t * world, vec2_t mouse_position)
@@ -76,9 +99,9 @@ void DisplayTileInfo(world_t * world, vec2_t mouse_position)
           tile->lighting.z);
 }
 
-void DisplayPlayerINV_(array_t * actors)
+void DisplayPlayerINV_(world_t * world)
 {
-    actor_t * player = GetActorType(actors, ACTOR_PLAYER);
+    actor_t * player = GetActor(world, world->player);
     inventory_t * inventory = player->info.player.inventory;
 
     int row = 0;
@@ -98,24 +121,51 @@ void DisplayPlayerINV_(array_t * actors)
     }
 }
 
+// One pixel per chunk, scaled up when drawn. Only uploaded when a chunk's
+// state changes.
+static SDL_Texture * chunk_map;
+static SDL_Color chunk_map_pixels[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+
 void DisplayChunkMap(world_t * world)
 {
+    SDL_Color pixels[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+
     for ( int y = 0; y < WORLD_HEIGHT / CHUNK_SIZE; y++ ) {
         for ( int x = 0; x < WORLD_WIDTH / CHUNK_SIZE; x++ ) {
             int darken = (x + y) % 2 == 0 ? -32 : 0;
-            int size = TILE_SIZE;
-            SDL_Rect r = { x * size, y * size, size, size };
             if ( world->loaded_chunks[y][x] ) {
-                V_SetRGB(255 + darken, 64 + darken, 64 + darken);
-                V_FillRect(&r);
+                pixels[y][x] = (SDL_Color){ 255 + darken, 64 + darken, 64 + darken, 255 };
+            } else if ( world->generating_chunks[y][x] ) {
+                pixels[y][x] = (SDL_Color){ 255 + darken, 255 + darken, 64 + darken, 255 };
             } else {
-                V_SetRGB(64 + darken, 255 + darken, 64 + darken);
-                V_FillRect(&r);
+                pixels[y][x] = (SDL_Color){ 64 + darken, 255 + darken, 64 + darken, 255 };
             }
         }
     }
 
-    actor_t * player = GetActorType(world->actors, ACTOR_PLAYER);
+    if ( chunk_map == NULL ) {
+        chunk_map = SDL_CreateTexture
+        (   renderer,
+            SDL_PIXELFORMAT_RGBA32,
+            SDL_TEXTUREACCESS_STREAMING,
+            WORLD_WIDTH / CHUNK_SIZE,
+            WORLD_HEIGHT / CHUNK_SIZE );
+        SDL_UpdateTexture(chunk_map, NULL, pixels, sizeof(pixels[0]));
+        memcpy(chunk_map_pixels, pixels, sizeof(pixels));
+    } else if ( memcmp(chunk_map_pixels, pixels, sizeof(pixels)) != 0 ) {
+        SDL_UpdateTexture(chunk_map, NULL, pixels, sizeof(pixels[0]));
+        memcpy(chunk_map_pixels, pixels, sizeof(pixels));
+    }
+
+    SDL_Rect dst = {
+        0,
+        0,
+        WORLD_WIDTH / CHUNK_SIZE * TILE_SIZE,
+        WORLD_HEIGHT / CHUNK_SIZE * TILE_SIZE
+    };
+    V_DrawTexture(chunk_map, NULL, &dst);
+
+    actor_t * player = GetActor(world, world->player);
     vec2_t pt = { player->pos.x / SCALED_TILE_SIZE, player->pos.y / SCALED_TILE_SIZE };
     V_SetGray(255);
     SDL_RenderDrawLine(renderer, pt.x, 0, pt.x, WORLD_HEIGHT);
@@ -135,6 +185,16 @@ void DisplayChunkMap(world_t * world)
     screen.w /= SCALED_TILE_SIZE;
     screen.h /= SCALED_TILE_SIZE;
     V_DrawRect(&screen);
+
+    int seen = prefetch_hits + prefetch_misses;
+    V_PrintString(0, (WORLD_HEIGHT / CHUNK_SIZE) * TILE_SIZE, "Prefetch: %d hits, %d misses (%.1f%%)",
+          prefetch_hits,
+          prefetch_misses,
+          seen ? prefetch_hits * 100.0f / seen : 0.0f);
+    V_PrintString(0, (WORLD_HEIGHT / CHUNK_SIZE) * TILE_SIZE + V_CharHeight(),
+          "Seed: %u, %d chunk worker(s)",
+          world->seed,
+          chunk_workers);
 }
 
 void DisplayDebugInfo(world_t * world, vec2_t mouse_position)
@@ -145,8 +205,19 @@ void DisplayDebugInfo(world_t * world, vec2_t mouse_position)
 
     // draw debug world texture
     if ( show_world ) {
+        UpdateDebugMap(world);
         SDL_Rect dst = { 0, 0, GAME_HEIGHT, GAME_HEIGHT };
         V_DrawTexture(world->debug_map, NULL, &dst);
+
+        // Outline the screen.
+        float scale = (float)GAME_HEIGHT / WORLD_HEIGHT / SCALED_TILE_SIZE;
+        SDL_Rect screen = GetVisibleRect(world->camera);
+        screen.x *= scale;
+        screen.y *= scale;
+        screen.w *= scale;
+        screen.h *= scale;
+        V_SetGray(255);
+        V_DrawRect(&screen);
     }
 
     if ( show_debug_info ) {
@@ -158,7 +229,7 @@ void DisplayDebugInfo(world_t * world, vec2_t mouse_position)
     }
 
     if ( show_inventory ) {
-        DisplayPlayerINV_(world->actors);
+        DisplayPlayerINV_(world);
     }
 
     if ( show_chunk_map ) {
@@ -178,12 +249,6 @@ bool ProcessDebugEvent(game_t * game, const SDL_Event * event)
             return true;
         case SDLK_F2:
             show_world = !show_world;
-            if ( show_world ) {
-                UpdateDebugMap
-                (   game->world->tiles,
-                    &game->world->debug_map,
-                    game->world->camera );
-            }
             return true;
         case SDLK_F3:
             show_geometry = !show_geometry;
@@ -194,6 +259,10 @@ bool ProcessDebugEvent(game_t * game, const SDL_Event * event)
         case SDLK_F5:
             show_chunk_map = !show_chunk_map;
             return true;
+        case SDLK_F6:
+            grass_effect_variants = !grass_effect_variants;
+            InvalidateAllTerrain(game->world);
+            return true;
         case SDLK_RIGHT:
             game->world->clock += HOUR_TICKS / 2;
             return true;
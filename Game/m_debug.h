@@ -19,11 +19,17 @@ extern bool show_chunk_map;
 extern int frame;
 extern int frame_ms;
 extern int render_ms;
+extern int render_draw_calls;
+extern int frame_texture_lookups;
+extern int frame_array_allocations;
 extern int update_ms;
 extern float debug_dt;
 extern int debug_hours;
 extern int debug_minutes;
 extern vec2_t mouse_tile;
+extern int prefetch_hits;
+extern int prefetch_misses;
+extern int chunk_workers;
 
 void DisplayDebugInfo(world_t * world, vec2_t mouse_position);
 bool ProcessDebugEvent(game_t * game, const SDL_Event * event);
@@ -6,6 +6,13 @@
 //
 
 #include "g_game.h"
+#include "w_world.h"
+#include "mylib/array.h"
+#include "mylib/mathlib.h"
+#include "mylib/stack.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 /*
  RESOURCES
@@ -24,8 +31,43 @@
  TODO: tile effect texture noise generation too slow
  */
 
-int main(void)
+int main(int argc, char ** argv)
 {
+    // Game -pregen [name]: generate a world headless and exit.
+    if ( argc >= 2 && strcmp(argv[1], "-pregen") == 0 ) {
+        PregenerateWorld(argc >= 3 ? argv[2] : "world");
+        return 0;
+    }
+
+    // Game -checkgeneration: check that chunk workers generate the same
+    // chunks as a single thread, then exit.
+    if ( argc >= 2 && strcmp(argv[1], "-checkgeneration") == 0 ) {
+        return CheckChunkGeneration() ? 0 : 1;
+    }
+
+    // Game -benchmark: time noise, contact finding, and the containers,
+    // print the results, and exit.
+    if ( argc >= 2 && strcmp(argv[1], "-benchmark") == 0 ) {
+        NoiseBenchmark();
+        ContactBenchmark();
+        ArrayBenchmark();
+        StackBenchmark();
+        return 0;
+    }
+
+    for ( int i = 1; i < argc; i++ ) {
+        if ( strcmp(argv[i], "-terraincache") == 0 && i + 1 < argc ) {
+            // -terraincache <MB>: baked chunk terrain texture memory budget.
+            terrain_cache_budget = (size_t)atoi(argv[++i]) * 1024 * 1024;
+        } else if ( strcmp(argv[i], "-effectvariants") == 0 ) {
+            // Bake grass effects from a fixed pool.
+            grass_effect_variants = true;
+        } else if ( strcmp(argv[i], "-checkcontacts") == 0 ) {
+            // Cross-check the contact grid with brute force every tick.
+            check_contacts = true;
+        }
+    }
+
     G_Main();
     return 0;
 }
@@ -6,14 +6,53 @@
 //
 
 #include "array.h"
+#include "genlib.h"
 #include <string.h>
 
 #define EL(arr, i) (arr->data + arr->esize * (i))
 
+int array_allocations;
+
+void Reserve(array_t * arr, int capacity) {
+    if ( capacity <= arr->capacity )
+        return;
+
+    void * data = realloc(arr->data, capacity * arr->esize);
+    if ( data == NULL )
+        Error("could not grow array to %d elements", capacity);
+
+    arr->data = data;
+    arr->capacity = capacity;
+    array_allocations++;
+}
+
+// Make room for `count` elements, at least doubling the capacity so that
+// appending one at a time doesn't realloc every time.
+static void Grow(array_t * arr, int count) {
+    if ( count <= arr->capacity )
+        return;
+
+    int capacity = arr->capacity ? arr->capacity * 2 : 8;
+    if ( capacity < count )
+        capacity = count;
+
+    Reserve(arr, capacity);
+}
+
 void * Append(array_t * arr, void * element) {
     return Insert(arr, element, arr->count);
 }
 
+void * AppendMany(array_t * arr, void * elements, int count) {
+    Grow(arr, arr->count + count);
+
+    void * first = EL(arr, arr->count);
+    memcpy(first, elements, arr->esize * count);
+    arr->count += count;
+
+    return first;
+}
+
 void * GetElement(array_t * arr, int i) {
     if ( (unsigned)i >= arr->count )
         return NULL;
@@ -34,9 +73,11 @@ array_t * NewArray(int count, size_t esize) {
     array_t * arr;
 
     arr = malloc(sizeof *arr);
-    arr->data = malloc(count * esize);
+    arr->data = NULL;
     arr->count = count;
+    arr->capacity = 0;
     arr->esize = esize;
+    Reserve(arr, count);
 
     return arr;
 }
@@ -45,7 +86,7 @@ void * Insert(array_t * arr, void * element, int i) {
     if ( (unsigned)i > arr->count ) // inserting at data[count] is valid
         return NULL;
 
-    arr->data = realloc(arr->data, (arr->count + 1) * arr->esize);
+    Grow(arr, arr->count + 1);
 
     // move the latter part of the array right
     memmove(arr->data + arr->esize * (i + 1),
@@ -97,3 +138,70 @@ void * GetLastElement(array_t * arr)
 
     return NULL;
 }
+
+#pragma mark - BENCHMARK
+
+// About the size of an actor.
+typedef struct {
+    char bytes[256];
+} bench_element_t;
+
+static void PrintResult(const char * name, float start, int allocations_start) {
+    printf("- %-28s %8.3f ms, %6d allocations\n",
+           name,
+           (ProgramTime() - start) * 1000.0f,
+           array_allocations - allocations_start);
+}
+
+void ArrayBenchmark(void) {
+    const int count = 100000;
+    const int remove_count = 5000; // Ordered removal is quadratic.
+
+    bench_element_t * elements = calloc(count, sizeof(*elements));
+    if ( elements == NULL )
+        Error("could not allocate benchmark elements");
+
+    printf("array benchmark (%d byte elements):\n", (int)sizeof(*elements));
+
+    array_t * arr = NewArray(0, sizeof(*elements));
+    float start = ProgramTime();
+    int allocations = array_allocations;
+    for ( int i = 0; i < count; i++ )
+        Append(arr, &elements[i]);
+    PrintResult("Append x 100000", start, allocations);
+    FreeArray(arr);
+
+    arr = NewArray(0, sizeof(*elements));
+    start = ProgramTime();
+    allocations = array_allocations;
+    Reserve(arr, count);
+    for ( int i = 0; i < count; i++ )
+        Append(arr, &elements[i]);
+    PrintResult("Reserve, Append x 100000", start, allocations);
+    FreeArray(arr);
+
+    arr = NewArray(0, sizeof(*elements));
+    start = ProgramTime();
+    allocations = array_allocations;
+    AppendMany(arr, elements, count);
+    PrintResult("AppendMany 100000", start, allocations);
+
+    // Remove every other element, going backwards as when removing
+    // flagged actors.
+    arr->count = remove_count;
+    start = ProgramTime();
+    allocations = array_allocations;
+    for ( int i = arr->count - 1; i >= 0; i -= 2 )
+        Remove(arr, i);
+    PrintResult("Remove half of 5000", start, allocations);
+
+    arr->count = remove_count;
+    start = ProgramTime();
+    allocations = array_allocations;
+    for ( int i = arr->count - 1; i >= 0; i -= 2 )
+        FastRemove(arr, i);
+    PrintResult("FastRemove half of 5000", start, allocations);
+
+    FreeArray(arr);
+    free(elements);
+}
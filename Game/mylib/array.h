@@ -15,12 +15,19 @@ typedef struct
     void *  data;
     size_t  esize;
     int     count; // current num of elements
+    int     capacity; // num of elements there's room for
 } array_t;
 
+/// Number of times any array's storage has been (re)allocated. Compare
+/// before and after some code to see how many it caused.
+extern int array_allocations;
+
 array_t *   NewArray(int count, size_t esize);
 void        FreeArray(array_t *);
-void        Clear(array_t *);
+void        Clear(array_t *); // Keeps capacity
+void        Reserve(array_t *, int capacity); // Make room, count is unchanged
 void *      Append(array_t *, void * element); // Push at end
+void *      AppendMany(array_t *, void * elements, int count); // Returns first
 void *      GetElement(array_t *, int index);
 void *      Insert(array_t *, void * element, int index);
 void        Replace(array_t *, void * element, int index);
@@ -29,4 +36,7 @@ void        FastRemove(array_t * arr, int index);
 void *      PopLast(array_t * arr);
 void *      GetLastElement(array_t * arr);
 
+/// Print timings and allocation counts for common array use.
+void        ArrayBenchmark(void);
+
 #endif /* array_h */
@@ -98,8 +98,47 @@ float RandomFloat(float min, float max);
 /// `percent` between 0 and 1
 bool Chance(float percent);
 
+#pragma mark - RNG STREAMS
+
+/// A counter-based random number generator. Each value is a hash of the
+/// stream's key and a counter, so a stream produces the same sequence no matter
+/// when or on which thread it's used. Streams don't share any state.
+typedef struct {
+    u64 key;
+    u64 counter;
+} rng_t;
+
+/// Start a stream. Streams with the same `seed` and `stream` produce the same
+/// sequence.
+void InitRNG(rng_t * rng, u32 seed, u32 stream);
+
+/// `Random` for an RNG stream.
+u32 RNGRandom(rng_t * rng, u32 min, u32 max);
+
+/// `RandomFloat` for an RNG stream.
+float RNGRandomFloat(rng_t * rng, float min, float max);
+
+/// `Chance` for an RNG stream.
+bool RNGChance(rng_t * rng, float percent);
+
 #pragma mark - NOISE
 
+/// A noise permutation table. Once initialized it is never modified, so one
+/// context can be shared by any number of threads.
+typedef struct {
+    u8 p[512];
+} noise_context_t;
+
+/// Convenience context for code that doesn't need its own. Starts out with
+/// Ken Perlin's reference permutation.
+extern noise_context_t default_noise;
+
+/// Shuffle `ctx`'s permutation table. The same seed always gives the same
+/// table. Does not touch the random number generator.
+void InitNoiseContext(noise_context_t * ctx, u32 seed);
+
+/// Reinitialize `default_noise` with `seed`. Not thread safe: don't call while
+/// other threads may be using `default_noise`.
 void RandomizeNoise(u32 seed);
 
 /// Perlin noise at point x, y, z.
@@ -107,7 +146,8 @@ void RandomizeNoise(u32 seed);
 /// - Parameter persistense: `0.0...1.0`
 /// - Parameter lacunarity: > `1.0`
 float Noise2
-(   float x,
+(   const noise_context_t * ctx,
+    float x,
     float y,
     float z,
     float frequency,
@@ -116,11 +156,36 @@ float Noise2
     float persistence,
     float lacunarity );
 
+/// Fill `out` with a `width` x `height` grid of `Noise2` samples spaced one
+/// unit apart: `out[row * width + col]` is `Noise2(x + col, y + row, z, ...)`.
+/// Uses SIMD lanes where available. For integral `x` and `y` the results are
+/// bit-identical to calling `Noise2` for each sample.
+void NoiseGrid2
+(   const noise_context_t * ctx,
+    float * out,
+    int   width,
+    int   height,
+    float x,
+    float y,
+    float z,
+    float frequency,
+    int   octaves,
+    float amplitude,
+    float persistence,
+    float lacunarity );
+
+/// Print `Noise2` vs. `NoiseGrid2` throughput and check they match.
+void NoiseBenchmark(void);
+
 /// Perlin noise at point x, y, z. Uses common default noise parameters. Use
 /// `Perlin2` if you need to specify these parameters.
-inline float Noise(float x, float y, float z)
+inline float Noise
+(   const noise_context_t * ctx,
+    float x,
+    float y,
+    float z )
 {
-    return Noise2(x, y, z, 0.01, 6, 1.0, 0.5, 2.0);
+    return Noise2(ctx, x, y, z, 0.01, 6, 1.0, 0.5, 2.0);
 }
 
 #endif /* __MATHLIB_H__ */
@@ -3,6 +3,16 @@
 #include "texture.h"
 #include "video.h"
 
+// Sprites not in a resolved table are loaded by name on first use.
+static SDL_Texture * SpriteTexture(sprite_t * sprite)
+{
+    if ( sprite->texture == NULL ) {
+        sprite->texture = GetTexture(sprite->texture_name);
+    }
+
+    return sprite->texture;
+}
+
 void DrawSprite
 (   sprite_t * sprite,
     int cell_x,
@@ -20,7 +30,7 @@ void DrawSprite
     src.y += cell_y * h;
     SDL_Rect dst = { dst_x, dst_y, w * scale, h * scale };
 
-    SDL_Texture * texture = GetTexture(sprite->texture_name);
+    SDL_Texture * texture = SpriteTexture(sprite);
 
     if ( sprite->transparent ) {
         SDL_SetTextureAlphaMod(texture, sprite->alpha);
@@ -29,8 +39,309 @@ void DrawSprite
     V_DrawTextureFlip(texture, &src, &dst, flip);
 }
 
+void BlitSprite
+(   sprite_t * sprite,
+    int cell_x,
+    int cell_y,
+    SDL_Surface * dst,
+    int dst_x,
+    int dst_y,
+    SDL_RendererFlip flip )
+{
+    SDL_Surface * src = GetSurface(sprite->texture_name);
+    if ( src == NULL ) {
+        Error("could not get surface for %s", sprite->texture_name);
+    }
+
+    int w = sprite->location.w;
+    int h = sprite->location.h;
+    int src_x = sprite->location.x + cell_x * w;
+    int src_y = sprite->location.y + cell_y * h;
+    int alpha_mod = sprite->transparent ? sprite->alpha : 255;
+
+    for ( int y = 0; y < h; y++ ) {
+        int dy = dst_y + y;
+        if ( dy < 0 || dy >= dst->h ) {
+            continue;
+        }
+
+        int sy = src_y + (flip & SDL_FLIP_VERTICAL ? h - 1 - y : y);
+        u8 * src_row = (u8 *)src->pixels + sy * src->pitch;
+        u8 * dst_row = (u8 *)dst->pixels + dy * dst->pitch;
+
+        for ( int x = 0; x < w; x++ ) {
+            int dx = dst_x + x;
+            if ( dx < 0 || dx >= dst->w ) {
+                continue;
+            }
+
+            int sx = src_x + (flip & SDL_FLIP_HORIZONTAL ? w - 1 - x : x);
+            u8 * s = &src_row[sx * 4];
+            u8 * d = &dst_row[dx * 4];
+
+            // Same as SDL_BLENDMODE_BLEND.
+            int a = s[3] * alpha_mod / 255;
+            for ( int i = 0; i < 3; i++ ) {
+                d[i] = (s[i] * a + d[i] * (255 - a)) / 255;
+            }
+            d[3] = a + d[3] * (255 - a) / 255;
+        }
+    }
+}
+
 void SetSpriteColorMod(sprite_t * sprite, vec3_t color_mod)
 {
-    SDL_Texture * texture = GetTexture(sprite->texture_name);
+    SDL_Texture * texture = SpriteTexture(sprite);
     SDL_SetTextureColorMod(texture, color_mod.x, color_mod.y, color_mod.z);
 }
+
+void ResolveSprites(sprite_t * sprites, int count)
+{
+    for ( int i = 0; i < count; i++ ) {
+        sprites[i].texture = GetTexture(sprites[i].texture_name);
+        if ( sprites[i].texture == NULL ) {
+            Error("could not load texture %s for sprite %d",
+                  sprites[i].texture_name,
+                  i);
+        }
+    }
+}
+
+#pragma mark - RENDER QUEUE
+
+typedef struct {
+    u8 layer;
+    int y;
+    SDL_Texture * texture; // NULL for a filled rect.
+    SDL_Color color;
+    int sequence; // Queue order, to keep the sort stable.
+
+    SDL_Rect src;
+    SDL_Rect dst;
+    SDL_RendererFlip flip;
+} sprite_command_t;
+
+static sprite_command_t * queue;
+static int queue_count;
+static int queue_capacity;
+
+// Flush buffers, four vertices and six indices per command.
+static SDL_Vertex * vertices;
+static int * indices;
+static int buffer_capacity; // In commands.
+
+static sprite_command_t * NewCommand(void)
+{
+    if ( queue_count == queue_capacity ) {
+        queue_capacity = queue_capacity ? queue_capacity * 2 : 256;
+        queue = realloc(queue, queue_capacity * sizeof(*queue));
+        if ( queue == NULL ) {
+            Error("could not grow sprite queue");
+        }
+    }
+
+    sprite_command_t * command = &queue[queue_count];
+    command->sequence = queue_count++;
+
+    return command;
+}
+
+void QueueSprite
+(   sprite_t * sprite,
+    int cell_x,
+    int cell_y,
+    int dst_x,
+    int dst_y,
+    int scale,
+    SDL_RendererFlip flip,
+    vec3_t color_mod,
+    u8 layer,
+    int y )
+{
+    int w = sprite->location.w;
+    int h = sprite->location.h;
+
+    SDL_Rect src = sprite->location;
+    src.x += cell_x * w;
+    src.y += cell_y * h;
+    SDL_Rect dst = { dst_x, dst_y, w * scale, h * scale };
+
+    SDL_Color color = {
+        color_mod.x,
+        color_mod.y,
+        color_mod.z,
+        sprite->transparent ? sprite->alpha : 255
+    };
+
+    sprite_command_t * command = NewCommand();
+    command->layer = layer;
+    command->y = y;
+    command->texture = SpriteTexture(sprite);
+    command->color = color;
+    command->src = src;
+    command->dst = dst;
+    command->flip = flip;
+}
+
+void QueueTexture
+(   SDL_Texture * texture,
+    const SDL_Rect * src,
+    const SDL_Rect * dst,
+    SDL_Color color,
+    u8 layer,
+    int y )
+{
+    sprite_command_t * command = NewCommand();
+    command->layer = layer;
+    command->y = y;
+    command->texture = texture;
+    command->color = color;
+    command->src = *src;
+    command->dst = *dst;
+    command->flip = SDL_FLIP_NONE;
+}
+
+void QueueRect(const SDL_Rect * rect, SDL_Color color, u8 layer, int y)
+{
+    sprite_command_t * command = NewCommand();
+    command->layer = layer;
+    command->y = y;
+    command->texture = NULL;
+    command->color = color;
+    command->dst = *rect;
+}
+
+static u32 ColorKey(SDL_Color color)
+{
+    return (u32)color.r << 24 | color.g << 16 | color.b << 8 | color.a;
+}
+
+static int CompareCommands(const void * a, const void * b)
+{
+    const sprite_command_t * c1 = a;
+    const sprite_command_t * c2 = b;
+
+    if ( c1->layer != c2->layer ) {
+        return c1->layer < c2->layer ? -1 : 1;
+    }
+
+    if ( c1->y != c2->y ) {
+        return c1->y < c2->y ? -1 : 1;
+    }
+
+    if ( c1->texture != c2->texture ) {
+        return (uintptr_t)c1->texture < (uintptr_t)c2->texture ? -1 : 1;
+    }
+
+    u32 color1 = ColorKey(c1->color);
+    u32 color2 = ColorKey(c2->color);
+    if ( color1 != color2 ) {
+        return color1 < color2 ? -1 : 1;
+    }
+
+    return c1->sequence - c2->sequence;
+}
+
+static void GrowBuffers(int count)
+{
+    if ( count <= buffer_capacity ) {
+        return;
+    }
+
+    vertices = realloc(vertices, count * 4 * sizeof(*vertices));
+    indices = realloc(indices, count * 6 * sizeof(*indices));
+    if ( vertices == NULL || indices == NULL ) {
+        Error("could not grow sprite buffers");
+    }
+
+    for ( int i = buffer_capacity; i < count; i++ ) {
+        int * quad = &indices[i * 6];
+        quad[0] = i * 4 + 0;
+        quad[1] = i * 4 + 1;
+        quad[2] = i * 4 + 2;
+        quad[3] = i * 4 + 2;
+        quad[4] = i * 4 + 1;
+        quad[5] = i * 4 + 3;
+    }
+
+    buffer_capacity = count;
+}
+
+// Fill in the vertices for one command's quad.
+static void CommandQuad(const sprite_command_t * command, float tex_w, float tex_h, SDL_Vertex * v)
+{
+    float left = command->dst.x;
+    float top = command->dst.y;
+    float right = left + command->dst.w;
+    float bottom = top + command->dst.h;
+
+    v[0].position = (SDL_FPoint){ left, top };
+    v[1].position = (SDL_FPoint){ right, top };
+    v[2].position = (SDL_FPoint){ left, bottom };
+    v[3].position = (SDL_FPoint){ right, bottom };
+
+    for ( int i = 0; i < 4; i++ ) {
+        v[i].color = command->color;
+    }
+
+    if ( command->texture == NULL ) {
+        return;
+    }
+
+    float u1 = command->src.x / tex_w;
+    float v1 = command->src.y / tex_h;
+    float u2 = (command->src.x + command->src.w) / tex_w;
+    float v2 = (command->src.y + command->src.h) / tex_h;
+
+    if ( command->flip & SDL_FLIP_HORIZONTAL ) {
+        SWAP(u1, u2);
+    }
+
+    if ( command->flip & SDL_FLIP_VERTICAL ) {
+        SWAP(v1, v2);
+    }
+
+    v[0].tex_coord = (SDL_FPoint){ u1, v1 };
+    v[1].tex_coord = (SDL_FPoint){ u2, v1 };
+    v[2].tex_coord = (SDL_FPoint){ u1, v2 };
+    v[3].tex_coord = (SDL_FPoint){ u2, v2 };
+}
+
+void FlushSpritesInOrder(void)
+{
+    if ( queue_count == 0 ) {
+        return;
+    }
+
+    GrowBuffers(queue_count);
+
+    // One draw per run of the same texture.
+    int run_start = 0;
+    while ( run_start < queue_count ) {
+        SDL_Texture * texture = queue[run_start].texture;
+
+        int tex_w = 1;
+        int tex_h = 1;
+        if ( texture ) {
+            SDL_QueryTexture(texture, NULL, NULL, &tex_w, &tex_h);
+        }
+
+        int run_end = run_start;
+        while ( run_end < queue_count && queue[run_end].texture == texture ) {
+            CommandQuad(&queue[run_end], tex_w, tex_h, &vertices[(run_end - run_start) * 4]);
+            run_end++;
+        }
+
+        int count = run_end - run_start;
+        V_DrawGeometry(texture, vertices, count * 4, indices, count * 6);
+        run_start = run_end;
+    }
+
+    queue_count = 0;
+}
+
+void FlushSprites(void)
+{
+    qsort(queue, queue_count, sizeof(*queue), CompareCommands);
+    FlushSpritesInOrder();
+}
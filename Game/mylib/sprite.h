@@ -12,6 +12,7 @@
 // laid out horizontally
 typedef struct {
     const char * texture_name;
+    SDL_Texture * texture; // Resolved from `texture_name` by `ResolveSprites()`.
     u8 draw_order; // lower values are drawn first (in back)
     SDL_Rect location; // source rect in sprite sheet
     u8 num_frames; // If not animated, refers to the number of varients.
@@ -41,6 +42,69 @@ void DrawSprite
     int scale,
     SDL_RendererFlip flip );
 
+/// Alpha blend a sprite cell onto an `SDL_PIXELFORMAT_RGBA32` surface,
+/// without the renderer. Parameters are as for `DrawSprite`, at scale 1. The
+/// sprite is clipped to the surface.
+void BlitSprite
+(   sprite_t * sprite,
+    int cell_x,
+    int cell_y,
+    SDL_Surface * dst,
+    int dst_x,
+    int dst_y,
+    SDL_RendererFlip flip );
+
 void SetSpriteColorMod(sprite_t * sprite, vec3_t color_mod);
 
+/// Look up the texture of each sprite in a table once, so drawing doesn't
+/// have to go through the texture hash table. Sprites that aren't resolved
+/// are looked up by name when first drawn.
+///
+/// The program is terminated via `Error()` if a texture can't be loaded.
+void ResolveSprites(sprite_t * sprites, int count);
+
+#pragma mark - RENDER QUEUE
+
+// Draws can be queued instead of going straight to the renderer. Queued draws
+// are sorted by layer, then by y within a layer, then by texture and color,
+// and flushed as one SDL_RenderGeometry per run of the same texture. Color
+// and alpha mods are stored with each draw as vertex colors, so the shared
+// texture's mods are never touched.
+
+/// Queue a sprite draw. Parameters are as for `DrawSprite`, plus:
+/// - Parameter color_mod: Color to multiply the sprite by.
+/// - Parameter layer: Lower layers are drawn first.
+/// - Parameter y: Order within the layer: lower values are drawn first. Use
+///   the same value for sprites that don't overlap to batch them better.
+void QueueSprite
+(   sprite_t * sprite,
+    int cell_x,
+    int cell_y,
+    int dst_x,
+    int dst_y,
+    int scale,
+    SDL_RendererFlip flip,
+    vec3_t color_mod,
+    u8 layer,
+    int y );
+
+/// Queue a draw of part of a texture. `color` is the color and alpha mod.
+void QueueTexture
+(   SDL_Texture * texture,
+    const SDL_Rect * src,
+    const SDL_Rect * dst,
+    SDL_Color color,
+    u8 layer,
+    int y );
+
+/// Queue a filled rectangle, drawn with the renderer's blend mode.
+void QueueRect(const SDL_Rect * rect, SDL_Color color, u8 layer, int y);
+
+/// Draw everything queued, in order, to the current render target.
+void FlushSprites(void);
+
+/// Like `FlushSprites()`, but draw in the order things were queued, for
+/// callers that have already sorted them. Layer and y are ignored.
+void FlushSpritesInOrder(void);
+
 #endif /* SPRITE_H */
@@ -12,8 +12,11 @@ struct mystack {
     void * data;
     size_t esize;
     int top;
+    int capacity; // In elements.
 };
 
+int stack_allocations;
+
 mystack_t * NewStack(size_t esize)
 {
     mystack_t * stack = malloc(sizeof(*stack));
@@ -23,6 +26,7 @@ mystack_t * NewStack(size_t esize)
 
     stack->data = NULL;
     stack->top = -1;
+    stack->capacity = 0;
     stack->esize = esize;
 
     return stack;
@@ -55,11 +59,17 @@ void * Push(mystack_t * stack, void * data)
 {
     ++stack->top;
 
-    void * temp = realloc(stack->data, (stack->top + 1) * stack->esize);
-    if ( temp == NULL ) {
-        Error("failed to reallocate stack");
+    // Double the capacity, so pushing doesn't realloc every time.
+    if ( stack->top == stack->capacity ) {
+        int capacity = stack->capacity ? stack->capacity * 2 : 16;
+        void * temp = realloc(stack->data, capacity * stack->esize);
+        if ( temp == NULL ) {
+            Error("failed to reallocate stack");
+        }
+        stack->data = temp;
+        stack->capacity = capacity;
+        stack_allocations++;
     }
-    stack->data = temp;
 
     void * top = Peek(stack);
     memmove(top, data, stack->esize);
@@ -79,6 +89,36 @@ void * Pop(mystack_t * stack)
     return top;
 }
 
+void StackBenchmark(void)
+{
+    const int count = 1000000;
+    const int rounds = 10;
+
+    mystack_t * stack = NewStack(sizeof(int));
+    int allocations = stack_allocations;
+    float start = ProgramTime();
+
+    // Fill it and empty it again. Later rounds reuse the storage.
+    for ( int round = 0; round < rounds; round++ ) {
+        for ( int i = 0; i < count; i++ ) {
+            Push(stack, &i);
+        }
+
+        while ( !IsStackEmpty(stack) ) {
+            Pop(stack);
+        }
+    }
+
+    printf("stack benchmark:\n");
+    printf("- %d x push/pop %d ints: %8.3f ms, %d allocations\n",
+           rounds,
+           count,
+           (ProgramTime() - start) * 1000.0f,
+           stack_allocations - allocations);
+
+    FreeStack(stack);
+}
+
 
 
 #if 0
@@ -13,6 +13,9 @@
 
 typedef struct mystack mystack_t;
 
+/// Number of times any stack's storage has been (re)allocated.
+extern int stack_allocations;
+
 mystack_t * NewStack(size_t element_size);
 void        FreeStack(mystack_t * stack);
 bool        IsStackEmpty(mystack_t * stack);
@@ -20,4 +23,7 @@ void *      Peek(mystack_t * stack);
 void *      Push(mystack_t * stack, void * data);
 void *      Pop(mystack_t * stack);
 
+/// Print timings and allocation counts for pushing and popping.
+void        StackBenchmark(void);
+
 #endif /* stack_h */
@@ -23,9 +23,22 @@ struct texture_node {
 
 static texture_node_t * texture_table[HASH_TABLE_SIZE];
 
+int texture_lookups;
+
+typedef struct surface_node surface_node_t;
+struct surface_node {
+    char * key;
+    SDL_Surface * surface;
+    surface_node_t * next;
+};
+
+// CPU-side copies of images, for drawing without the renderer.
+static surface_node_t * surface_table[HASH_TABLE_SIZE];
+
 SDL_Texture * GetTexture(const char * name)
 {
     static int total_textures = 0;
+    texture_lookups++;
     unsigned index = StringHash(name) % HASH_TABLE_SIZE;
 
     // Find the texture.
@@ -67,6 +80,41 @@ SDL_Texture * GetTexture(const char * name)
     return texture;
 }
 
+SDL_Surface * GetSurface(const char * name)
+{
+    unsigned index = StringHash(name) % HASH_TABLE_SIZE;
+
+    surface_node_t * entry = surface_table[index];
+    while ( entry ) {
+        if ( strcmp(name, entry->key) == 0 ) {
+            return entry->surface;
+        }
+        entry = entry->next;
+    }
+
+    // Surface not found, load it.
+    SDL_Surface * surface = NULL;
+    SDL_Surface * loaded = IMG_Load(name);
+    if ( loaded != NULL ) {
+        surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+    }
+
+    if ( surface ) {
+        surface_node_t * node = malloc(sizeof(*node));
+        if ( node == NULL ) {
+            Error("could not allocate surface hash table node");
+        }
+
+        node->key = SDL_strdup(name);
+        node->surface = surface;
+        node->next = surface_table[index];
+        surface_table[index] = node;
+    }
+
+    return surface;
+}
+
 // debug
 void PrintTextureHashTable(void)
 {
@@ -85,6 +133,7 @@ void PrintTextureHashTable(void)
     }
 }
 
+// Sprite texture handles resolved by ResolveSprites() are invalid after this.
 void FreeAllTextures(void)
 {
     for ( int i = 0; i < HASH_TABLE_SIZE; i++ ) {
@@ -99,6 +148,20 @@ void FreeAllTextures(void)
 
             node = next;
         }
+        texture_table[i] = NULL;
+
+        surface_node_t * surface_node = surface_table[i];
+
+        while ( surface_node ) {
+            surface_node_t * next = surface_node->next;
+
+            SDL_FreeSurface(surface_node->surface);
+            free(surface_node->key);
+            free(surface_node);
+
+            surface_node = next;
+        }
+        surface_table[i] = NULL;
     }
 }
 
@@ -22,6 +22,17 @@ void LoadTextures(const char * directory_name, const char * file_extension);
 ///   the program is terminated via a cell of `Error()`.
 SDL_Texture * GetTexture(const char * key);
 
+/// The number of `GetTexture()` calls so far. Compare before and after
+/// drawing something to see how many hash lookups it cost.
+extern int texture_lookups;
+
+/// Get a CPU-side, `SDL_PIXELFORMAT_RGBA32` copy of an image, for drawing
+/// without the renderer. Loaded on first use.
+///
+/// - Parameter key: The file name of the image.
+/// - Returns: The requested surface, or `NULL` if it could not be loaded.
+SDL_Surface * GetSurface(const char * key);
+
 SDL_Rect GetScaledTextureSize(SDL_Texture * texture, int draw_scale);
 
 void FreeAllTextures(void);
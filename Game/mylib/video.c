@@ -12,9 +12,13 @@
 
 SDL_Window * window;
 SDL_Renderer * renderer;
+int draw_calls;
+
+static void FreeGlyphAtlases(void);
 
 static void CleanUp(void)
 {
+    FreeGlyphAtlases();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_QuitSubSystem(SDL_INIT_VIDEO);
@@ -165,6 +169,12 @@ extern inline void V_DrawTextureFlip
     SDL_Rect * src,
     SDL_Rect * dst,
     SDL_RendererFlip flip );
+extern inline void V_DrawGeometry
+(   SDL_Texture * texture,
+    const SDL_Vertex * vertices,
+    int num_vertices,
+    const int * indices,
+    int num_indices );
 
 #pragma mark - TEXT
 
@@ -213,82 +223,290 @@ int V_CharHeight(void)
     return info[font].height * scaleY;
 }
 
-void V_PrintChar(int x, int y, unsigned char character)
+#pragma mark - GLYPH ATLAS
+
+// Each font's 256 characters in a 16 x 16 grid, white where lit. Text is
+// drawn as quads from this, tinted with the draw color.
+#define ATLAS_COLUMNS 16
+
+static SDL_Texture * glyph_atlas[NUM_FONTS];
+
+static SDL_Texture * GlyphAtlas(font_t f)
 {
-    if ( renderer == NULL ) {
-        Error("no font renderer is set, use SetFontRenderer()");
+    if ( glyph_atlas[f] ) {
+        return glyph_atlas[f];
     }
 
-    // save the current render scale
-    float oldScaleX;
-    float oldScaleY;
-    SDL_RenderGetScale(renderer, &oldScaleX, &oldScaleY);
-    SDL_RenderSetScale(renderer, scaleX * oldScaleX, scaleY * oldScaleY);
+    const int w = info[f].width;
+    const int h = info[f].height;
+    const int atlas_w = w * ATLAS_COLUMNS;
+    const int atlas_h = h * (256 / ATLAS_COLUMNS);
 
-    // scale drawing but not coordinates
-    const int unscaledX = (float)x / scaleX;
-    const int unscaledY = (float)y / scaleY;
+    u32 * pixels = calloc(atlas_w * atlas_h, sizeof(*pixels));
+    if ( pixels == NULL ) {
+        Error("could not allocate glyph atlas pixels");
+    }
 
-    const int w = info[font].width;
-    const int h = info[font].height;
-    const int bytesPerChar = (w * h) / 8;
-    const u8 * data = &info[font].data[character * bytesPerChar];
+    const u8 * data = info[f].data;
     int bit = 7;
 
-    for ( int row = 0; row < h; row++ ) {
-        for ( int col = 0; col < w; col++ ) {
-
-            if ( *data & (1 << bit) ) {
-                SDL_RenderDrawPoint(renderer, unscaledX + col, unscaledY + row);
+    for ( int character = 0; character < 256; character++ ) {
+        int x0 = (character % ATLAS_COLUMNS) * w;
+        int y0 = (character / ATLAS_COLUMNS) * h;
+
+        for ( int row = 0; row < h; row++ ) {
+            for ( int col = 0; col < w; col++ ) {
+                if ( *data & (1 << bit) ) {
+                    // RGBA32 is R, G, B, A in memory order.
+                    u8 * p = (u8 *)&pixels[(y0 + row) * atlas_w + x0 + col];
+                    p[0] = p[1] = p[2] = p[3] = 255;
+                }
+
+                if ( --bit < 0 ) {
+                    ++data;
+                    bit = 7;
+                }
             }
+        }
+    }
 
-            if ( --bit < 0 ) {
-                ++data;
-                bit = 7;
-            }
+    glyph_atlas[f] = SDL_CreateTexture
+    (   renderer,
+        SDL_PIXELFORMAT_RGBA32,
+        SDL_TEXTUREACCESS_STATIC,
+        atlas_w,
+        atlas_h );
+
+    if ( glyph_atlas[f] == NULL ) {
+        Error("could not create glyph atlas: %s", SDL_GetError());
+    }
+
+    SDL_UpdateTexture(glyph_atlas[f], NULL, pixels, atlas_w * sizeof(*pixels));
+    SDL_SetTextureBlendMode(glyph_atlas[f], SDL_BLENDMODE_BLEND);
+    free(pixels);
+
+    return glyph_atlas[f];
+}
+
+static void FreeGlyphAtlases(void)
+{
+    for ( int i = 0; i < NUM_FONTS; i++ ) {
+        if ( glyph_atlas[i] ) {
+            SDL_DestroyTexture(glyph_atlas[i]);
+            glyph_atlas[i] = NULL;
         }
     }
+}
 
-    // restore previous render scale
-    SDL_RenderSetScale(renderer, oldScaleX, oldScaleY);
+// Fill in the four vertices of character's quad at x, y.
+static void GlyphQuad
+(   unsigned char character,
+    float x,
+    float y,
+    SDL_Color color,
+    SDL_Vertex * v )
+{
+    const float w = info[font].width;
+    const float h = info[font].height;
+    const float u = (float)(character % ATLAS_COLUMNS) / ATLAS_COLUMNS;
+    const float t = (float)(character / ATLAS_COLUMNS) / (256 / ATLAS_COLUMNS);
+    const float du = 1.0f / ATLAS_COLUMNS;
+    const float dt = 1.0f / (256 / ATLAS_COLUMNS);
+
+    v[0] = (SDL_Vertex){ { x, y }, color, { u, t } };
+    v[1] = (SDL_Vertex){ { x + w * scaleX, y }, color, { u + du, t } };
+    v[2] = (SDL_Vertex){ { x, y + h * scaleY }, color, { u, t + dt } };
+    v[3] = (SDL_Vertex){ { x + w * scaleX, y + h * scaleY }, color, { u + du, t + dt } };
 }
 
-void V_PrintString(int x, int y, const char * format, ...)
+// Six indices per glyph quad, shared by all text.
+static int * glyph_indices;
+static int glyph_indices_capacity; // In glyphs.
+
+static const int * GlyphIndices(int num_glyphs)
 {
-    va_list args[2];
-    va_start(args[0], format);
-    va_copy(args[1], args[0]);
+    if ( num_glyphs > glyph_indices_capacity ) {
+        glyph_indices = realloc(glyph_indices, num_glyphs * 6 * sizeof(*glyph_indices));
+        if ( glyph_indices == NULL ) {
+            Error("could not grow glyph indices");
+        }
 
-    int len = vsnprintf(NULL, 0, format, args[0]);
-    char * buffer = calloc(len + 1, sizeof(*buffer));
-    vsnprintf(buffer, len + 1, format, args[1]);
-    va_end(args[0]);
-    va_end(args[1]);
+        for ( int i = glyph_indices_capacity; i < num_glyphs; i++ ) {
+            int * quad = &glyph_indices[i * 6];
+            quad[0] = i * 4 + 0;
+            quad[1] = i * 4 + 1;
+            quad[2] = i * 4 + 2;
+            quad[3] = i * 4 + 2;
+            quad[4] = i * 4 + 1;
+            quad[5] = i * 4 + 3;
+        }
+
+        glyph_indices_capacity = num_glyphs;
+    }
+
+    return glyph_indices;
+}
+
+static SDL_Color DrawColor(void)
+{
+    SDL_Color color;
+    SDL_GetRenderDrawColor(renderer, &color.r, &color.g, &color.b, &color.a);
+
+    return color;
+}
+
+void V_PrintChar(int x, int y, unsigned char character)
+{
+    if ( renderer == NULL ) {
+        Error("no font renderer is set, use SetFontRenderer()");
+    }
+
+    SDL_Vertex vertices[4];
+    GlyphQuad(character, x, y, DrawColor(), vertices);
+    V_DrawGeometry(GlyphAtlas(font), vertices, 4, GlyphIndices(1), 6);
+}
+
+#pragma mark - TEXT LAYOUT CACHE
+
+// Laid out strings, so text that's the same as last frame (same string,
+// position, font, scale, and color) is drawn without doing it again.
+// Direct mapped by a hash of the string and position.
+#define TEXT_CACHE_SIZE 64
+
+typedef struct {
+    char * text; // NULL if unused.
+    int text_capacity;
+    int x;
+    int y;
+    font_t font;
+    float scale_x;
+    float scale_y;
+    SDL_Color color;
+
+    SDL_Vertex * vertices; // Four per glyph.
+    int num_glyphs;
+    int glyph_capacity;
+} text_layout_t;
+
+static text_layout_t text_cache[TEXT_CACHE_SIZE];
+
+// Formatted strings go here, grown as needed.
+static char * text_buffer;
+static int text_buffer_size;
+
+static bool LayoutMatches
+(   const text_layout_t * layout,
+    const char * text,
+    int x,
+    int y,
+    SDL_Color color )
+{
+    return layout->text
+        && layout->x == x
+        && layout->y == y
+        && layout->font == font
+        && layout->scale_x == scaleX
+        && layout->scale_y == scaleY
+        && layout->color.r == color.r
+        && layout->color.g == color.g
+        && layout->color.b == color.b
+        && layout->color.a == color.a
+        && strcmp(layout->text, text) == 0;
+}
+
+static void LayOutText
+(   text_layout_t * layout,
+    const char * text,
+    int x,
+    int y,
+    SDL_Color color )
+{
+    int len = (int)strlen(text);
+
+    if ( len + 1 > layout->text_capacity ) {
+        layout->text_capacity = len + 1;
+        layout->text = realloc(layout->text, layout->text_capacity);
+    }
+
+    // At most one glyph per character.
+    if ( len > layout->glyph_capacity ) {
+        layout->glyph_capacity = len;
+        layout->vertices = realloc(layout->vertices, len * 4 * sizeof(*layout->vertices));
+    }
+
+    if ( layout->text == NULL || (len && layout->vertices == NULL) ) {
+        Error("could not grow text layout");
+    }
+
+    memcpy(layout->text, text, len + 1);
+    layout->x = x;
+    layout->y = y;
+    layout->font = font;
+    layout->scale_x = scaleX;
+    layout->scale_y = scaleY;
+    layout->color = color;
+    layout->num_glyphs = 0;
 
-    const char * c = buffer;
     int x1 = x;
     int y1 = y;
     int w = info[font].width * scaleX;
     int h = info[font].height * scaleY;
+    int tab = tabSize * w;
 
-    while ( *c ) {
+    for ( const char * c = text; *c; c++ ) {
         switch ( *c ) {
             case '\n':
                 y1 += h;
                 x1 = x;
                 break;
             case '\t':
-                while ( (++x1 - x) % (tabSize * w) != 0 )
-                    ;
+                if ( tab > 0 ) {
+                    x1 = x + ((x1 - x) / tab + 1) * tab;
+                }
                 break;
-            default:
-                V_PrintChar(x1, y1, *c);
+            default: {
+                SDL_Vertex * v = &layout->vertices[layout->num_glyphs++ * 4];
+                GlyphQuad(*c, x1, y1, color, v);
                 x1 += w;
                 break;
+            }
+        }
+    }
+}
+
+void V_PrintString(int x, int y, const char * format, ...)
+{
+    va_list args[2];
+    va_start(args[0], format);
+    va_copy(args[1], args[0]);
+
+    int len = vsnprintf(NULL, 0, format, args[0]);
+    if ( len + 1 > text_buffer_size ) {
+        text_buffer_size = len + 1;
+        text_buffer = realloc(text_buffer, text_buffer_size);
+        if ( text_buffer == NULL ) {
+            Error("could not grow text buffer");
         }
+    }
 
-        c++;
+    vsnprintf(text_buffer, len + 1, format, args[1]);
+    va_end(args[0]);
+    va_end(args[1]);
+
+    SDL_Color color = DrawColor();
+    unsigned hash = StringHash(text_buffer) ^ (unsigned)(x * 31 + y * 131);
+    text_layout_t * layout = &text_cache[hash % TEXT_CACHE_SIZE];
+
+    if ( !LayoutMatches(layout, text_buffer, x, y, color) ) {
+        LayOutText(layout, text_buffer, x, y, color);
     }
 
-    free(buffer);
+    if ( layout->num_glyphs > 0 ) {
+        V_DrawGeometry
+        (   GlyphAtlas(font),
+            layout->vertices,
+            layout->num_glyphs * 4,
+            GlyphIndices(layout->num_glyphs),
+            layout->num_glyphs * 6 );
+    }
 }
@@ -32,6 +32,10 @@ typedef enum {
 extern SDL_Window * window;
 extern SDL_Renderer * renderer;
 
+/// Number of texture and geometry draws submitted so far. Compare before and
+/// after drawing something to see what it cost.
+extern int draw_calls;
+
 /// Initialize window and renderer with options specified in `info`.
 /// - Parameter info: `NULL` or Zero values indicate default values
 ///   should be used.
@@ -112,6 +116,7 @@ inline void V_SetGray(u8 gray)
 ///   to draw to entire target.
 inline void V_DrawTexture(SDL_Texture * texture, SDL_Rect * src, SDL_Rect * dst)
 {
+    draw_calls++;
     SDL_RenderCopy(renderer, texture, src, dst);
 }
 
@@ -121,9 +126,24 @@ inline void V_DrawTextureFlip
     SDL_Rect * dst,
     SDL_RendererFlip flip )
 {
+    draw_calls++;
     SDL_RenderCopyEx(renderer, texture, src, dst, 0.0, NULL, flip);
 }
 
+/// Draw triangles textured with `texture`, or untextured if it's `NULL`.
+/// - Parameter indices: Three per triangle, or `NULL` if the vertices are
+///   already in triangle order.
+inline void V_DrawGeometry
+(   SDL_Texture * texture,
+    const SDL_Vertex * vertices,
+    int num_vertices,
+    const int * indices,
+    int num_indices )
+{
+    draw_calls++;
+    SDL_RenderGeometry(renderer, texture, vertices, num_vertices, indices, num_indices);
+}
+
 /// Create an SDL_Texture with that can be used as a rendering target.
 SDL_Texture * V_CreateTexture(int w, int h);
 
@@ -136,7 +156,8 @@ typedef enum {
     FONT_ATARI_4X8,
     FONT_CP437_8X16,
     FONT_CP437_8X8,
-    FONT_NES_16X16
+    FONT_NES_16X16,
+    NUM_FONTS
 } font_t;
 
 void V_SetFont(font_t font);
@@ -150,12 +171,15 @@ int V_CharWidth(void);
 int V_CharHeight(void);
 
 /// Render ASCII character at pixel coordinate (x, y) using current renderer
-/// color.
+/// color. Characters are drawn from a texture of the font's glyphs, which is
+/// created the first time the font is used.
 void V_PrintChar(int x, int y, unsigned char character);
 
 ///  Render string at pixel coordinate (x, y) using current renderer color.
 ///
-///  The control characters \n and \t are handled as expected.
+///  The control characters \n and \t are handled as expected. The string is
+///  drawn as one batch of glyphs. Layouts are cached, so text that's
+///  unchanged from the last frame isn't laid out again.
 void V_PrintString(int x, int y, const char * format, ...);
 
 
@@ -15,6 +15,15 @@ typedef enum {
     DRAW_ORDER_FOREGROUND,
 } draw_order_t;
 
+// Render queue layers (see QueueSprite()). Lower layers are drawn first.
+typedef enum {
+    LAYER_TERRAIN,
+    LAYER_TERRAIN_EFFECTS,
+    LAYER_ITEMS, // Collectibles lie under everything else.
+    LAYER_SHADOWS,
+    LAYER_ACTORS, // Plus the sprite's draw_order, so keep this last.
+} render_layer_t;
+
 // TODO: order this alphabetically?
 typedef enum {
     SPRITE_PLAYER_STAND,
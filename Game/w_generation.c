@@ -8,8 +8,11 @@
 
 #include "w_world.h"
 #include "g_game.h"
+#include "m_debug.h"
 #include "mylib/video.h"
 
+#include <time.h>
+
 static const float terrain_elevations[NUM_TERRAIN_TYPES] = {
     -1.00, // deep ocean
     -0.45, // shallow ocean
@@ -22,7 +25,7 @@ static const float terrain_elevations[NUM_TERRAIN_TYPES] = {
 
 // Used by GenerateTerrain() to initialize and set up a world tile at x, y, and
 // assign its properties according a noise value for the tile.
-static void SetUpTile(tile_t * tile, float tile_noise)
+static void SetUpTile(tile_t * tile, float tile_noise, rng_t * rng)
 {
     // select terrain per noise (elevation)
     for ( int i = 0; i < NUM_TERRAIN_TYPES - 1; i++ ) {
@@ -32,29 +35,65 @@ static void SetUpTile(tile_t * tile, float tile_noise)
         }
     }
 
-    tile->variety = Random(0, 255);
-    tile->effect = NULL;
+    tile->variety = RNGRandom(rng, 0, 255);
 }
 
-// This is filled by GenerateTerrain during world generation
-// and is used in later stages of generation.
-struct {
-    int x, y;
-    tile_t * tile;
-} grass_tiles[WORLD_WIDTH * WORLD_HEIGHT];
-int num_grass_tiles = 0;
-
-// Used by CreateWorld() to generate all terrain.
-bool initial_generation;
-static void GenerateTerrainInChunk(world_t * world, chunk_coord_t chunk_coord)
-{
-    RandomizeNoise(0);
+// Set by PregenerateWorld() and CheckChunkGeneration(), which run without a
+// window.
+static bool pregenerating;
 
+// An actor to be spawned when a generated chunk is committed to the world.
+typedef struct {
+    actor_type_t type;
+    position_t position;
+    int z;
+} chunk_spawn_t;
+
+// A chunk being generated by a worker thread. Workers only ever write to
+// their own job, so nothing in the world is touched until the main thread
+// commits the finished job.
+//
+// Everything a worker reads comes from the job, and all randomness comes from
+// the job's RNG stream, which is keyed by the world seed and chunk coordinate.
+// A chunk therefore comes out the same regardless of the order chunks are
+// generated in or which worker generates it.
+typedef struct {
+    chunk_coord_t coord;
+    const noise_context_t * noise;
+    rng_t rng;
+
+    // Time spent in each stage, for generation_stats.
+    float terrain_time;
+    float actors_time;
+    tile_t tiles[CHUNK_SIZE][CHUNK_SIZE];
+
+    int num_spawns;
+    chunk_spawn_t spawns[CHUNK_SIZE * CHUNK_SIZE];
+} chunk_job_t;
+
+static void GenerateTerrainInChunk(chunk_job_t * job)
+{
     float half_width = WORLD_WIDTH / 2.0f;
     float half_height = WORLD_HEIGHT / 2.0f;
 
-//    num_grass_tiles = 0;
-    tile_coord_t corner = ChunkToTile(chunk_coord);
+    tile_coord_t corner = ChunkToTile(job->coord);
+
+    // Elevation noise for the whole chunk.
+    float elevation[CHUNK_SIZE][CHUNK_SIZE];
+    NoiseGrid2
+    (   job->noise,
+        &elevation[0][0],
+        CHUNK_SIZE,
+        CHUNK_SIZE,
+        corner.x,
+        corner.y,
+        1.0f,
+        0.01f,
+        6,
+        1.0f,
+        0.5f,
+        2.0f );
+
     tile_coord_t tile_coord;
     for (tile_coord.y = corner.y;
          tile_coord.y < corner.y + CHUNK_SIZE;
@@ -81,31 +120,19 @@ static void GenerateTerrainInChunk(world_t * world, chunk_coord_t chunk_coord)
                 // A gradient is applied around the world center: the farther
                 // out a tile is, the more it's elevation is lowered.
                 gradient = MAP(distance, 0.0f, half_height, 0.0f, 1.0f);
-                noise = Noise2
-                (   tile_coord.x,
-                    tile_coord.y,
-                    1.0f,
-                    0.01f,
-                    6,
-                    1.0f,
-                    0.5f,
-                    2.0f);
+                noise = elevation
+                    [tile_coord.y - corner.y]
+                    [tile_coord.x - corner.x];
                 noise -= gradient;
             } else {
                 // Outside the circular mask, land is removed entirely.
                 noise = -1.0f;
             }
 
-            tile_t * tile = GetTile(world->tiles, tile_coord.x, tile_coord.y);
-            SetUpTile(tile, noise);
-
-            // Track grass tiles for player spawn.
-            if ( initial_generation && tile->terrain >= TERRAIN_GRASS ) {
-                grass_tiles[num_grass_tiles].tile = tile;
-                grass_tiles[num_grass_tiles].x = tile_coord.x;
-                grass_tiles[num_grass_tiles].y = tile_coord.y;
-                num_grass_tiles++;
-            }
+            tile_t * tile = &job->tiles
+                [tile_coord.y - corner.y]
+                [tile_coord.x - corner.x];
+            SetUpTile(tile, noise, &job->rng);
         }
     }
 }
@@ -113,68 +140,100 @@ static void GenerateTerrainInChunk(world_t * world, chunk_coord_t chunk_coord)
 // track occupied tiles during generation
 static bool occupied[WORLD_HEIGHT][WORLD_WIDTH];
 
-// TODO: Ensure the player does not spawn on a tiny off-shore island.
-// Get the highest elevation tile in the spawn region and
-// flood fill from it to get a list of tiles that are (hopefully) on a main
-// island.
+#define SPAWN_CANDIDATES        256  // Grass tiles nearest the center.
+#define SPAWN_MIN_ISLAND_TILES  1024 // Smaller land masses are skipped.
+
+static bool IsTileLoaded(world_t * world, int x, int y)
+{
+    return world->loaded_chunks[y / CHUNK_SIZE][x / CHUNK_SIZE];
+}
+
+// Spawn the player on one of the grass tiles nearest the center of the world,
+// skipping tiles on small islands. Only generated chunks are searched.
 void SpawnPlayer(world_t * world)
 {
-    // make a list of grass tiles ordered by how close they are to the
-    // the center of the world and select one at random
-
-    int center_x = WORLD_WIDTH / 2;
-    int center_y = WORLD_HEIGHT / 2;
-
-    int num_potentials = 0;
-    struct potential_tile {
-        tile_coord_t tile_coord;
-        int distance;
-    } potentials[WORLD_WIDTH * WORLD_HEIGHT];
-
-    // fill the list
-    // TODO: only check generated chunks
-    for ( int y = 0; y < WORLD_HEIGHT; y++ ) {
-        for ( int x = 0; x < WORLD_WIDTH; x++ ) {
-            tile_t * tile = GetTile(world->tiles, x, y);
-            if ( tile->terrain == TERRAIN_GRASS ) {
-                potentials[num_potentials].tile_coord.x = x;
-                potentials[num_potentials].tile_coord.y = y;
-                potentials[num_potentials].distance
-                    = DISTANCE(x, y, center_x, center_y);
-                num_potentials++;
+    tile_coord_t candidates[SPAWN_CANDIDATES];
+    int num_candidates = 0;
+
+    // Collect grass tiles in square rings around the center until there are
+    // enough. Each ring is finished so that no side of it is favored.
+    tile_coord_t center = { WORLD_WIDTH / 2, WORLD_HEIGHT / 2 };
+    int max_radius = MAX(WORLD_WIDTH, WORLD_HEIGHT) / 2;
+
+    for ( int r = 0; r <= max_radius && num_candidates < SPAWN_CANDIDATES; r++ ) {
+        for ( int y = center.y - r; y <= center.y + r; y++ ) {
+            // Only the first and last rows are fully on the ring.
+            int step = (y == center.y - r || y == center.y + r) ? 1 : r * 2;
+
+            for ( int x = center.x - r; x <= center.x + r; x += step ) {
+                if ( x < 0 || x >= WORLD_WIDTH || y < 0 || y >= WORLD_HEIGHT ) {
+                    continue;
+                }
+
+                if ( !IsTileLoaded(world, x, y) ) {
+                    continue;
+                }
+
+                if (   GetTile(world->tiles, x, y)->terrain == TERRAIN_GRASS
+                    && num_candidates < SPAWN_CANDIDATES )
+                {
+                    candidates[num_candidates++] = (tile_coord_t){ x, y };
+                }
             }
         }
     }
 
-    // sort the list by distance: earlier indices are closer to center of world
-    for ( int i = 0; i < num_potentials; i++ ) {
-        for ( int j = i + 1; j < num_potentials; j++ ) {
-            if ( potentials[j].distance < potentials[i].distance) {
-                SWAP(potentials[i], potentials[j]);
-            }
-        }
+    if ( num_candidates == 0 ) {
+        Error("Somehow there are no grass tiles near the world center!");
     }
 
-    const int spawn_tile_count = 256;
-    if ( num_potentials < spawn_tile_count ) {
-        Error("Somehow there are < %d grass tiles in the world!", spawn_tile_count);
+    // Try candidates at random, dropping any that are on a small island. If
+    // they're all on small islands, settle for the biggest one.
+    Randomize();
+    tile_coord_t spawn_tile = candidates[0];
+    int best_size = 0;
+
+    while ( num_candidates > 0 ) {
+        int i = Random(0, num_candidates - 1);
+        int size = GetIslandArea(world, candidates[i].x, candidates[i].y);
+
+        if ( size > best_size ) {
+            best_size = size;
+            spawn_tile = candidates[i];
+        }
+
+        if ( size >= SPAWN_MIN_ISLAND_TILES ) {
+            break;
+        }
+
+        candidates[i] = candidates[--num_candidates];
     }
 
-    // Select one of the 50 grass tiles closest to the center of world.
-    Randomize();
-    int i = Random(0, spawn_tile_count - 1);
-    occupied[potentials[i].tile_coord.y][potentials[i].tile_coord.x] = true;
+    occupied[spawn_tile.y][spawn_tile.x] = true;
 
-    position_t position = GetTileCenter(potentials[i].tile_coord);
-    SpawnActor(ACTOR_PLAYER, position, world);
-    world->player = (actor_t *)GetElement(world->actors, 0);
+    position_t position = GetTileCenter(spawn_tile);
+    world->player = SpawnActor(ACTOR_PLAYER, position, world)->handle;
     world->camera = position;
     world->camera_target = position;
 }
 
-void SpawnActorsInChunk(world_t * world, chunk_coord_t chunk_coord)
+static void QueueSpawn
+(   chunk_job_t * job,
+    actor_type_t type,
+    position_t position,
+    int z )
 {
-    tile_coord_t corner = ChunkToTile(chunk_coord);
+    chunk_spawn_t * spawn = &job->spawns[job->num_spawns++];
+    spawn->type = type;
+    spawn->position = position;
+    spawn->z = z;
+}
+
+// Roll for actors in a generated chunk. Actors aren't spawned here, since
+// this runs on a worker thread; they're queued and spawned in CommitChunk().
+static void SpawnActorsInChunk(chunk_job_t * job)
+{
+    tile_coord_t corner = ChunkToTile(job->coord);
 
     tile_coord_t tile_coord;
     for (tile_coord.y = corner.y;
@@ -185,44 +244,38 @@ void SpawnActorsInChunk(world_t * world, chunk_coord_t chunk_coord)
              tile_coord.x < corner.x + CHUNK_SIZE;
              tile_coord.x++ )
         {
-            if ( occupied[tile_coord.y][tile_coord.x] ) {
-                continue;
-            }
-
-            tile_t * tile = GetTile(world->tiles, tile_coord.x, tile_coord.y);
+            tile_t * tile = &job->tiles
+                [tile_coord.y - corner.y]
+                [tile_coord.x - corner.x];
             position_t v = GetTileCenter(tile_coord);
             float r = SCALED_TILE_SIZE / 3;
-            v.x += RandomFloat(-r, r);
-            v.y += RandomFloat(-r, r);
+            v.x += RNGRandomFloat(&job->rng, -r, r);
+            v.y += RNGRandomFloat(&job->rng, -r, r);
 
             switch ( tile->terrain ) {
                 case TERRAIN_GRASS:
                     // butterflies
-                    if ( Chance(1.0f / 80.0f) ) {
+                    if ( RNGChance(&job->rng, 1.0f / 80.0f) ) {
                         vec2_t p = GetTileCenter(tile_coord);
-                        actor_t * actor = SpawnActor(ACTOR_BUTTERFLY, p, world);
-                        actor->z = 16;
+                        QueueSpawn(job, ACTOR_BUTTERFLY, p, 16);
                         continue;
                     }
 
                     // trees
-                    if ( Chance(1.0f / 100.0f) ) {
-                        SpawnActor(ACTOR_TREE, v, world);
-                        occupied[tile_coord.y][tile_coord.x] = true;
+                    if ( RNGChance(&job->rng, 1.0f / 100.0f) ) {
+                        QueueSpawn(job, ACTOR_TREE, v, 0);
                         continue;
                     }
 
                     // bushes
-                    if ( Chance(1.0f / 50.0f) ) {
-                        SpawnActor(ACTOR_BUSH, v, world);
-                        occupied[tile_coord.y][tile_coord.x] = true;
+                    if ( RNGChance(&job->rng, 1.0f / 50.0f) ) {
+                        QueueSpawn(job, ACTOR_BUSH, v, 0);
                         continue;
                     }
                     break;
                 case TERRAIN_FOREST:
-                    if ( Chance(1.0f / 3.0f) ) {
-                        SpawnActor(ACTOR_TREE, v, world);
-                        occupied[tile_coord.y][tile_coord.x] = true;
+                    if ( RNGChance(&job->rng, 1.0f / 3.0f) ) {
+                        QueueSpawn(job, ACTOR_TREE, v, 0);
                         continue;
                     }
                     break;
@@ -304,29 +357,273 @@ void SpawnActors(world_t * world)
 //    return 0;
 //}
 
-void RenderAllGrassTextures(tile_t * world_tiles)
+#pragma mark - CHUNK WORKERS
+
+// Time spent in each generation stage since the world was created. Worker
+// stages are summed over all workers.
+static struct {
+    int num_chunks;
+    float terrain;
+    float actors;
+    float commit;
+} generation_stats;
+
+#define MAX_CHUNK_WORKERS 8
+#define NUM_CHUNKS ((WORLD_WIDTH / CHUNK_SIZE) * (WORLD_HEIGHT / CHUNK_SIZE))
+
+// Chunk generation is done by a pool of worker threads. The main thread
+// queues chunks with LoadChunkIfNeeded(), workers generate tiles and a spawn
+// list for each, and the main thread commits finished chunks to the world in
+// CommitGeneratedChunks().
+//
+// Each chunk is queued at most once until it's committed, so the queues
+// never hold more than NUM_CHUNKS jobs.
+static struct {
+    SDL_Thread * threads[MAX_CHUNK_WORKERS];
+    int num_threads;
+
+    SDL_mutex * lock;
+    SDL_cond * job_queued;
+    SDL_cond * job_finished;
+    bool quit;
+
+    // Jobs waiting for a worker (ring buffer).
+    chunk_job_t * queued[NUM_CHUNKS];
+    int queue_head;
+    int num_queued;
+
+    int num_working; // Jobs taken by a worker but not yet finished.
+
+    // Jobs waiting to be committed by the main thread.
+    chunk_job_t * finished[NUM_CHUNKS];
+    int num_finished;
+} workers;
+
+static int ChunkWorker(void * unused)
 {
-    for ( int i = 0; i < num_grass_tiles; i++ ) {
-        int x = grass_tiles[i].x;
-        int y = grass_tiles[i].y;
+    (void)unused;
 
-        tile_t * adjacents[NUM_DIRECTIONS];
-        GetAdjacentTiles(x, y, world_tiles, adjacents);
-        RenderGrassEffectTexture(grass_tiles[i].tile, adjacents, x, y);
+    SDL_LockMutex(workers.lock);
+
+    while ( true ) {
+        while ( workers.num_queued == 0 && !workers.quit ) {
+            SDL_CondWait(workers.job_queued, workers.lock);
+        }
+
+        if ( workers.quit ) {
+            break;
+        }
+
+        chunk_job_t * job = workers.queued[workers.queue_head];
+        workers.queue_head = (workers.queue_head + 1) % NUM_CHUNKS;
+        workers.num_queued--;
+        workers.num_working++;
+
+        SDL_UnlockMutex(workers.lock);
+        float start = ProgramTime();
+        GenerateTerrainInChunk(job);
+        float terrain_done = ProgramTime();
+        SpawnActorsInChunk(job);
+        job->terrain_time = terrain_done - start;
+        job->actors_time = ProgramTime() - terrain_done;
+        SDL_LockMutex(workers.lock);
+
+        workers.finished[workers.num_finished++] = job;
+        workers.num_working--;
+        SDL_CondSignal(workers.job_finished);
     }
+
+    SDL_UnlockMutex(workers.lock);
+
+    return 0;
 }
 
-void LoadChunkIfNeeded(world_t * world, chunk_coord_t chunk_coord)
+// Start `num_threads` workers, or if 0, one per core, leaving one for the
+// main thread unless pregenerating.
+static void StartChunkWorkers(int num_threads)
 {
+    workers.lock = SDL_CreateMutex();
+    workers.job_queued = SDL_CreateCond();
+    workers.job_finished = SDL_CreateCond();
+    if ( !workers.lock || !workers.job_queued || !workers.job_finished ) {
+        Error("could not create chunk worker sync objects: %s", SDL_GetError());
+    }
+
+    workers.quit = false;
+    workers.queue_head = 0;
+    workers.num_queued = 0;
+    workers.num_working = 0;
+    workers.num_finished = 0;
+
+    // Leave a core for the main thread, unless it has nothing else to do.
+    if ( num_threads == 0 ) {
+        num_threads = SDL_GetCPUCount() - (pregenerating ? 0 : 1);
+    }
+
+    workers.num_threads = num_threads;
+    CLAMP(workers.num_threads, 1, MAX_CHUNK_WORKERS);
+
+    for ( int i = 0; i < workers.num_threads; i++ ) {
+        workers.threads[i] = SDL_CreateThread(ChunkWorker, "chunk worker", NULL);
+        if ( workers.threads[i] == NULL ) {
+            Error("could not create chunk worker thread: %s", SDL_GetError());
+        }
+    }
+
+    chunk_workers = workers.num_threads;
+}
+
+void StopChunkWorkers(void)
+{
+    SDL_LockMutex(workers.lock);
+    workers.quit = true;
+    SDL_CondBroadcast(workers.job_queued);
+    SDL_UnlockMutex(workers.lock);
+
+    for ( int i = 0; i < workers.num_threads; i++ ) {
+        SDL_WaitThread(workers.threads[i], NULL);
+    }
+
+    // Discard any jobs that never got committed.
+    for ( int i = 0; i < workers.num_queued; i++ ) {
+        free(workers.queued[(workers.queue_head + i) % NUM_CHUNKS]);
+    }
+
+    for ( int i = 0; i < workers.num_finished; i++ ) {
+        free(workers.finished[i]);
+    }
+
+    SDL_DestroyCond(workers.job_finished);
+    SDL_DestroyCond(workers.job_queued);
+    SDL_DestroyMutex(workers.lock);
+    memset(&workers, 0, sizeof(workers));
+}
+
+// Copy a finished chunk's tiles into the world and spawn its actors.
+static void CommitChunk(world_t * world, chunk_job_t * job)
+{
+    chunk_coord_t chunk_coord = job->coord;
+
     if ( world->loaded_chunks[chunk_coord.y][chunk_coord.x] ) {
-        return;
+        return; // This should never happen.
+    }
+
+    float start = ProgramTime();
+
+    tile_coord_t corner = ChunkToTile(chunk_coord);
+    for ( int y = 0; y < CHUNK_SIZE; y++ ) {
+        tile_t * row = GetTile(world->tiles, corner.x, corner.y + y);
+        memcpy(row, job->tiles[y], sizeof(job->tiles[y]));
+    }
+
+    // Add the chunk's actors in one go, so the actor array grows at most
+    // once per chunk, geometrically.
+    static actor_t spawned[CHUNK_SIZE * CHUNK_SIZE];
+    for ( int i = 0; i < job->num_spawns; i++ ) {
+        chunk_spawn_t * spawn = &job->spawns[i];
+        spawned[i] = NewActor(spawn->type, spawn->position, world);
+        if ( spawn->z ) {
+            spawned[i].z = spawn->z;
+        }
     }
 
-    GenerateTerrainInChunk(world, chunk_coord);
-    SpawnActorsInChunk(world, chunk_coord);
+    AddActors(world, spawned, job->num_spawns);
 
+    LabelIslandsInChunk(world, chunk_coord);
+    InvalidateChunkTerrain(world, chunk_coord);
+
+    world->generating_chunks[chunk_coord.y][chunk_coord.x] = false;
     world->loaded_chunks[chunk_coord.y][chunk_coord.x] = true;
-    printf("loaded chunk %d, %d\n", chunk_coord.x, chunk_coord.y);
+
+    generation_stats.num_chunks++;
+    generation_stats.terrain += job->terrain_time;
+    generation_stats.actors += job->actors_time;
+    generation_stats.commit += ProgramTime() - start;
+}
+
+static void QueueChunkJob(chunk_job_t * job)
+{
+    SDL_LockMutex(workers.lock);
+    int tail = (workers.queue_head + workers.num_queued) % NUM_CHUNKS;
+    workers.queued[tail] = job;
+    workers.num_queued++;
+    SDL_CondSignal(workers.job_queued);
+    SDL_UnlockMutex(workers.lock);
+}
+
+// Take the finished list, so workers aren't held up while it's processed.
+static int TakeFinishedChunkJobs(chunk_job_t * finished[NUM_CHUNKS])
+{
+    SDL_LockMutex(workers.lock);
+    int num_finished = workers.num_finished;
+    memcpy(finished, workers.finished, num_finished * sizeof(finished[0]));
+    workers.num_finished = 0;
+    SDL_UnlockMutex(workers.lock);
+
+    return num_finished;
+}
+
+static void WaitForChunkJobs(void)
+{
+    SDL_LockMutex(workers.lock);
+    while ( workers.num_queued > 0 || workers.num_working > 0 ) {
+        SDL_CondWait(workers.job_finished, workers.lock);
+    }
+    SDL_UnlockMutex(workers.lock);
+}
+
+void CommitGeneratedChunks(world_t * world)
+{
+    chunk_job_t * finished[NUM_CHUNKS];
+    int num_finished = TakeFinishedChunkJobs(finished);
+
+    for ( int i = 0; i < num_finished; i++ ) {
+        CommitChunk(world, finished[i]);
+        free(finished[i]);
+    }
+}
+
+void WaitForGeneratedChunks(world_t * world)
+{
+    WaitForChunkJobs();
+    CommitGeneratedChunks(world);
+}
+
+static void InitChunkJob
+(   world_t * world,
+    chunk_job_t * job,
+    chunk_coord_t chunk_coord )
+{
+    memset(job, 0, sizeof(*job));
+    job->coord = chunk_coord;
+    job->noise = &world->terrain_noise;
+
+    u32 chunk_index = chunk_coord.y * (WORLD_WIDTH / CHUNK_SIZE) + chunk_coord.x;
+    InitRNG(&job->rng, world->seed, chunk_index);
+}
+
+void LoadChunkIfNeeded(world_t * world, chunk_coord_t chunk_coord)
+{
+    if (   chunk_coord.x < 0 || chunk_coord.x >= WORLD_WIDTH / CHUNK_SIZE
+        || chunk_coord.y < 0 || chunk_coord.y >= WORLD_HEIGHT / CHUNK_SIZE )
+    {
+        return;
+    }
+
+    if (   world->loaded_chunks[chunk_coord.y][chunk_coord.x]
+        || world->generating_chunks[chunk_coord.y][chunk_coord.x] )
+    {
+        return;
+    }
+
+    chunk_job_t * job = malloc(sizeof(*job));
+    if ( job == NULL ) {
+        Error("could not allocate chunk job");
+    }
+    InitChunkJob(world, job, chunk_coord);
+
+    world->generating_chunks[chunk_coord.y][chunk_coord.x] = true;
+    QueueChunkJob(job);
 }
 
 void LoadChunkInRegion(world_t * world, position_t center, int tile_radius)
@@ -356,6 +653,271 @@ void LoadChunkInRegion(world_t * world, position_t center, int tile_radius)
     }
 }
 
+// Hash of everything generation decides about a chunk.
+static u32 ChunkJobChecksum(const chunk_job_t * job)
+{
+    u32 hash = 2166136261u; // FNV-1a
+#define HASH(value) hash = (hash ^ (u32)(value)) * 16777619u
+
+    for ( int y = 0; y < CHUNK_SIZE; y++ ) {
+        for ( int x = 0; x < CHUNK_SIZE; x++ ) {
+            HASH(job->tiles[y][x].terrain);
+            HASH(job->tiles[y][x].variety);
+        }
+    }
+
+    for ( int i = 0; i < job->num_spawns; i++ ) {
+        HASH(job->spawns[i].type);
+        HASH(job->spawns[i].position.x * 1000.0f);
+        HASH(job->spawns[i].position.y * 1000.0f);
+        HASH(job->spawns[i].z);
+    }
+
+#undef HASH
+    return hash;
+}
+
+static chunk_coord_t ChunkIndexToCoord(int index)
+{
+    return (chunk_coord_t){
+        index % (WORLD_WIDTH / CHUNK_SIZE),
+        index / (WORLD_WIDTH / CHUNK_SIZE)
+    };
+}
+
+static int ChunkCoordToIndex(chunk_coord_t coord)
+{
+    return coord.y * (WORLD_WIDTH / CHUNK_SIZE) + coord.x;
+}
+
+// Generate every chunk with `num_threads` workers, queued in shuffled order,
+// and count the chunks whose checksums differ from `reference`.
+static int CheckWorkerGeneration
+(   world_t * world,
+    const u32 reference[NUM_CHUNKS],
+    int num_threads )
+{
+    StopChunkWorkers();
+    StartChunkWorkers(num_threads);
+
+    int order[NUM_CHUNKS];
+    for ( int i = 0; i < NUM_CHUNKS; i++ ) {
+        order[i] = i;
+    }
+
+    for ( int i = NUM_CHUNKS - 1; i > 0; i-- ) {
+        int j = Random(0, i);
+        SWAP(order[i], order[j]);
+    }
+
+    for ( int i = 0; i < NUM_CHUNKS; i++ ) {
+        chunk_job_t * job = malloc(sizeof(*job));
+        if ( job == NULL ) {
+            Error("could not allocate chunk job");
+        }
+
+        InitChunkJob(world, job, ChunkIndexToCoord(order[i]));
+        QueueChunkJob(job);
+    }
+
+    WaitForChunkJobs();
+
+    chunk_job_t * finished[NUM_CHUNKS];
+    int num_finished = TakeFinishedChunkJobs(finished);
+    if ( num_finished != NUM_CHUNKS ) {
+        Error("expected %d finished chunk jobs, got %d", NUM_CHUNKS, num_finished);
+    }
+
+    int mismatches = 0;
+    for ( int i = 0; i < num_finished; i++ ) {
+        chunk_coord_t coord = finished[i]->coord;
+
+        if ( ChunkJobChecksum(finished[i]) != reference[ChunkCoordToIndex(coord)] ) {
+            printf("chunk %d, %d differs with %d worker(s)\n",
+                   coord.x,
+                   coord.y,
+                   workers.num_threads);
+            mismatches++;
+        }
+
+        free(finished[i]);
+    }
+
+    return mismatches;
+}
+
+bool CheckChunkGeneration(void)
+{
+    static const int thread_counts[] = { 1, 2, 4, MAX_CHUNK_WORKERS };
+    static u32 reference[NUM_CHUNKS];
+
+    pregenerating = true;
+    world_t * world = CreateWorld();
+
+    // Reference: every chunk in order, on this thread.
+    chunk_job_t * job = malloc(sizeof(*job));
+    if ( job == NULL ) {
+        Error("could not allocate chunk job");
+    }
+
+    for ( int i = 0; i < NUM_CHUNKS; i++ ) {
+        InitChunkJob(world, job, ChunkIndexToCoord(i));
+        GenerateTerrainInChunk(job);
+        SpawnActorsInChunk(job);
+        reference[i] = ChunkJobChecksum(job);
+    }
+
+    free(job);
+
+    int total_mismatches = 0;
+    for ( int i = 0; i < (int)ARRAY_SIZE(thread_counts); i++ ) {
+        int mismatches = CheckWorkerGeneration(world, reference, thread_counts[i]);
+        printf("chunk generation with %d worker(s): %d of %d chunks differ\n",
+               workers.num_threads,
+               mismatches,
+               NUM_CHUNKS);
+        total_mismatches += mismatches;
+    }
+
+    DestroyWorld(world);
+    pregenerating = false;
+
+    return total_mismatches == 0;
+}
+
+#pragma mark - PREFETCH
+
+// The slowest speed assumed when estimating time-to-visibility, so that
+// while the player stands still, chunks are ranked by distance.
+#define PREFETCH_MIN_SPEED (SCALED_TILE_SIZE * 0.5f)
+
+// Don't queue prefetches while workers still have this many jobs per thread
+// waiting: chunks the player actually needs would queue up behind them.
+#define PREFETCH_MAX_BACKLOG 2
+
+// Estimate how many seconds until `chunk` scrolls into `view` when the view
+// moves at `velocity`.
+static float ChunkTimeToVisible(chunk_coord_t chunk, SDL_Rect view, vec2_t velocity)
+{
+    const float chunk_size = CHUNK_SIZE * SCALED_TILE_SIZE;
+
+    vec2_t chunk_center = {
+        (chunk.x + 0.5f) * chunk_size,
+        (chunk.y + 0.5f) * chunk_size
+    };
+    vec2_t view_center = { view.x + view.w / 2.0f, view.y + view.h / 2.0f };
+    vec2_t to_chunk = Vec2Subtract(chunk_center, view_center);
+
+    // Distance between the edges of the view and the chunk.
+    float gap_x = fabsf(to_chunk.x) - (view.w + chunk_size) / 2.0f;
+    float gap_y = fabsf(to_chunk.y) - (view.h + chunk_size) / 2.0f;
+    gap_x = MAX(gap_x, 0.0f);
+    gap_y = MAX(gap_y, 0.0f);
+    float gap = sqrtf(gap_x * gap_x + gap_y * gap_y);
+
+    if ( gap == 0.0f ) {
+        return 0.0f; // Already visible.
+    }
+
+    // How fast the view is closing in on the chunk.
+    float closing_speed
+        = (velocity.x * to_chunk.x + velocity.y * to_chunk.y)
+        / Vec2Length(to_chunk);
+
+    return gap / MAX(closing_speed, PREFETCH_MIN_SPEED);
+}
+
+// Count chunks that have just come into view: a hit if the chunk was
+// already loaded, a miss if it wasn't ready in time.
+static void UpdatePrefetchStats(world_t * world)
+{
+    const int chunk_size = CHUNK_SIZE * SCALED_TILE_SIZE;
+    SDL_Rect view = GetVisibleRect(world->camera);
+
+    chunk_coord_t min = { view.x / chunk_size, view.y / chunk_size };
+    chunk_coord_t max = {
+        (view.x + view.w) / chunk_size,
+        (view.y + view.h) / chunk_size
+    };
+    CLAMP(min.x, 0, WORLD_WIDTH / CHUNK_SIZE - 1);
+    CLAMP(min.y, 0, WORLD_HEIGHT / CHUNK_SIZE - 1);
+    CLAMP(max.x, 0, WORLD_WIDTH / CHUNK_SIZE - 1);
+    CLAMP(max.y, 0, WORLD_HEIGHT / CHUNK_SIZE - 1);
+
+    chunk_coord_t chunk;
+    for ( chunk.y = min.y; chunk.y <= max.y; chunk.y++ ) {
+        for ( chunk.x = min.x; chunk.x <= max.x; chunk.x++ ) {
+            if ( world->seen_chunks[chunk.y][chunk.x] ) {
+                continue;
+            }
+
+            world->seen_chunks[chunk.y][chunk.x] = true;
+            if ( world->loaded_chunks[chunk.y][chunk.x] ) {
+                prefetch_hits++;
+            } else {
+                prefetch_misses++;
+            }
+        }
+    }
+}
+
+void PrefetchChunks(world_t * world, vec2_t velocity)
+{
+    UpdatePrefetchStats(world);
+
+    SDL_LockMutex(workers.lock);
+    int backlog = workers.num_queued;
+    SDL_UnlockMutex(workers.lock);
+
+    if ( backlog >= workers.num_threads * PREFETCH_MAX_BACKLOG ) {
+        return;
+    }
+
+    SDL_Rect view = GetVisibleRect(world->camera_target);
+    chunk_coord_t center = PositionToChunk(world->camera_target);
+    int radius = CHUNK_PREFETCH_RADIUS_TILES / CHUNK_SIZE;
+
+    // The unloaded chunks that will be visible soonest, soonest first.
+    struct {
+        chunk_coord_t coord;
+        float time;
+    } best[CHUNK_PREFETCH_BUDGET];
+    int num_best = 0;
+
+    chunk_coord_t chunk;
+    for ( chunk.y = center.y - radius; chunk.y <= center.y + radius; chunk.y++ ) {
+        for ( chunk.x = center.x - radius; chunk.x <= center.x + radius; chunk.x++ ) {
+            if (   chunk.x < 0 || chunk.x >= WORLD_WIDTH / CHUNK_SIZE
+                || chunk.y < 0 || chunk.y >= WORLD_HEIGHT / CHUNK_SIZE
+                || world->loaded_chunks[chunk.y][chunk.x]
+                || world->generating_chunks[chunk.y][chunk.x] )
+            {
+                continue;
+            }
+
+            float time = ChunkTimeToVisible(chunk, view, velocity);
+
+            // Insert into the sorted list, dropping the latest if it's full.
+            int i = num_best < CHUNK_PREFETCH_BUDGET ? num_best++ : num_best;
+            while ( i > 0 && best[i - 1].time > time ) {
+                if ( i < CHUNK_PREFETCH_BUDGET ) {
+                    best[i] = best[i - 1];
+                }
+                i--;
+            }
+
+            if ( i < CHUNK_PREFETCH_BUDGET ) {
+                best[i].coord = chunk;
+                best[i].time = time;
+            }
+        }
+    }
+
+    for ( int i = 0; i < num_best; i++ ) {
+        LoadChunkIfNeeded(world, best[i].coord);
+    }
+}
+
 world_t * CreateWorld(void)
 {
     world_t * world = calloc(1, sizeof(*world));
@@ -365,23 +927,89 @@ world_t * CreateWorld(void)
 
     world->clock = MORNING_END_TICKS;
 
+    world->seed = (u32)time(NULL);
+    InitNoiseContext(&world->terrain_noise, world->seed);
+    InitNoiseContext(&world->effect_noise, 0);
+    InitIslands(world);
+    InitTerrainCache(world);
+
     memset(occupied, 0, sizeof(occupied));
+    prefetch_hits = 0;
+    prefetch_misses = 0;
+    memset(&generation_stats, 0, sizeof(generation_stats));
+    StartChunkWorkers(0);
 
     world->actors = NewArray(0, sizeof(actor_t));
     world->pending_actors = NewArray(0, sizeof(actor_t));
+    world->actor_slots = NewArray(0, sizeof(actor_slot_t));
+    world->free_actor_slot = -1;
+    world->player = NULL_ACTOR_HANDLE;
 
     // Generate tiles near the center of the world.
     PROFILE_START(spawn_generation);
-    initial_generation = true;
-    num_grass_tiles = 0;
     tile_coord_t center_tile = { WORLD_WIDTH / 2, WORLD_HEIGHT / 2 };
     LoadChunkInRegion(world, TileToPosition(center_tile), 32);
-    initial_generation = false;
+    WaitForGeneratedChunks(world);
     PROFILE_END(spawn_generation);
 
+    PROFILE_START(spawn_player);
     SpawnPlayer(world);
+    PROFILE_END(spawn_player);
 
     printf("num actors: %d\n", world->actors->count);
 
     return world;
 }
+
+#pragma mark - PREGENERATION
+
+void PregenerateWorld(const char * name)
+{
+    char world_path[256];
+    char map_path[256];
+    snprintf(world_path, sizeof(world_path), "%s.world", name);
+    snprintf(map_path, sizeof(map_path), "%s.png", name);
+
+    pregenerating = true;
+    float start = ProgramTime();
+    world_t * world = CreateWorld();
+    float created = ProgramTime();
+
+    // Queue everything that CreateWorld didn't generate.
+    chunk_coord_t chunk;
+    for ( chunk.y = 0; chunk.y < WORLD_HEIGHT / CHUNK_SIZE; chunk.y++ ) {
+        for ( chunk.x = 0; chunk.x < WORLD_WIDTH / CHUNK_SIZE; chunk.x++ ) {
+            LoadChunkIfNeeded(world, chunk);
+        }
+    }
+    WaitForGeneratedChunks(world);
+    float generated = ProgramTime();
+
+    SaveWorld(world, world_path);
+    float saved_world = ProgramTime();
+
+    SaveTerrainMap(world->tiles, map_path);
+    float saved_map = ProgramTime();
+
+    float generation_time = generated - start;
+    printf("\npregenerated %d chunks with %d worker(s) in %.1f ms "
+           "(%.0f chunks/sec)\n",
+           generation_stats.num_chunks,
+           workers.num_threads,
+           generation_time * 1000.0f,
+           generation_stats.num_chunks / generation_time);
+    printf("- create world:   %8.1f ms\n", (created - start) * 1000.0f);
+    printf("- all chunks:     %8.1f ms\n", (generated - created) * 1000.0f);
+    printf("  - terrain:      %8.1f ms (summed over workers)\n",
+           generation_stats.terrain * 1000.0f);
+    printf("  - actors:       %8.1f ms (summed over workers)\n",
+           generation_stats.actors * 1000.0f);
+    printf("  - commit:       %8.1f ms (main thread)\n",
+           generation_stats.commit * 1000.0f);
+    printf("- write %s: %8.1f ms\n", world_path, (saved_world - generated) * 1000.0f);
+    printf("- write %s: %8.1f ms\n", map_path, (saved_map - saved_world) * 1000.0f);
+    printf("%d actors\n", world->actors->count);
+
+    DestroyWorld(world);
+    pregenerating = false;
+}
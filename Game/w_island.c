@@ -0,0 +1,128 @@
+//
+//  w_island.c
+//  Game
+//
+//  Island labeling. Land tiles are joined into islands with a union-find as
+//  chunks are committed, so any code can ask which island a tile is on, and
+//  how big it is, without doing its own flood fill.
+
+#include "w_world.h"
+
+#define NO_ISLAND -1
+
+static bool IsLandTile(tile_t * tile)
+{
+    return tile->terrain >= TERRAIN_GRASS && tile->terrain < TERRAIN_END;
+}
+
+// Find the root of tile index `i`, halving the path along the way.
+static int FindIsland(island_map_t * islands, int i)
+{
+    while ( islands->parent[i] != i ) {
+        islands->parent[i] = islands->parent[islands->parent[i]];
+        i = islands->parent[i];
+    }
+
+    return i;
+}
+
+static void MergeIslands(island_map_t * islands, int a, int b)
+{
+    a = FindIsland(islands, a);
+    b = FindIsland(islands, b);
+
+    if ( a == b ) {
+        return;
+    }
+
+    // Attach the smaller island to the larger.
+    if ( islands->area[a] < islands->area[b] ) {
+        SWAP(a, b);
+    }
+
+    islands->parent[b] = a;
+    islands->area[a] += islands->area[b];
+}
+
+void InitIslands(world_t * world)
+{
+    for ( int i = 0; i < WORLD_WIDTH * WORLD_HEIGHT; i++ ) {
+        world->islands.parent[i] = NO_ISLAND;
+        world->islands.area[i] = 0;
+    }
+}
+
+void LabelIslandsInChunk(world_t * world, chunk_coord_t chunk_coord)
+{
+    island_map_t * islands = &world->islands;
+    tile_coord_t corner = ChunkToTile(chunk_coord);
+
+    // Each land tile starts as its own island.
+    for ( int y = corner.y; y < corner.y + CHUNK_SIZE; y++ ) {
+        for ( int x = corner.x; x < corner.x + CHUNK_SIZE; x++ ) {
+            int i = y * WORLD_WIDTH + x;
+            if ( IsLandTile(&world->tiles[i]) ) {
+                islands->parent[i] = i;
+                islands->area[i] = 1;
+            }
+        }
+    }
+
+    // Join with land to the north and west. Along the chunk's edges, also join
+    // with land to the south and east, which is labeled only if that chunk was
+    // committed earlier.
+    for ( int y = corner.y; y < corner.y + CHUNK_SIZE; y++ ) {
+        for ( int x = corner.x; x < corner.x + CHUNK_SIZE; x++ ) {
+            int i = y * WORLD_WIDTH + x;
+            if ( islands->parent[i] == NO_ISLAND ) {
+                continue;
+            }
+
+            if ( x > 0 && islands->parent[i - 1] != NO_ISLAND ) {
+                MergeIslands(islands, i, i - 1);
+            }
+
+            if ( y > 0 && islands->parent[i - WORLD_WIDTH] != NO_ISLAND ) {
+                MergeIslands(islands, i, i - WORLD_WIDTH);
+            }
+
+            if (   x == corner.x + CHUNK_SIZE - 1
+                && x + 1 < WORLD_WIDTH
+                && islands->parent[i + 1] != NO_ISLAND )
+            {
+                MergeIslands(islands, i, i + 1);
+            }
+
+            if (   y == corner.y + CHUNK_SIZE - 1
+                && y + 1 < WORLD_HEIGHT
+                && islands->parent[i + WORLD_WIDTH] != NO_ISLAND )
+            {
+                MergeIslands(islands, i, i + WORLD_WIDTH);
+            }
+        }
+    }
+}
+
+int GetIslandID(world_t * world, int x, int y)
+{
+    if ( x < 0 || x >= WORLD_WIDTH || y < 0 || y >= WORLD_HEIGHT ) {
+        return NO_ISLAND;
+    }
+
+    int i = y * WORLD_WIDTH + x;
+    if ( world->islands.parent[i] == NO_ISLAND ) {
+        return NO_ISLAND;
+    }
+
+    return FindIsland(&world->islands, i);
+}
+
+int GetIslandArea(world_t * world, int x, int y)
+{
+    int id = GetIslandID(world, x, y);
+    if ( id == NO_ISLAND ) {
+        return 0;
+    }
+
+    return world->islands.area[id];
+}
@@ -41,18 +41,74 @@ void GetAdjacentTiles
     out[WEST]  = GetTile(world_tiles, x - 1, y);
 }
 
-void DestroyWorld(world_t * world)
+// World file format, in native byte order:
+//
+//   char[4]    "WRLD"
+//   u32        version
+//   u32        seed
+//   u16        width, height (in tiles)
+//   width * height tiles, row by row:
+//     u8       terrain
+//     u8       variety
+//   u32        actor count
+//   per actor:
+//     u16      type
+//     float    x, y (world pixels)
+//     s16      z
+
+#define WORLD_FILE_VERSION 1
+
+void SaveWorld(world_t * world, const char * path)
 {
-    SDL_DestroyTexture(world->debug_map);
-    
+    FILE * file = OpenFile(path, "wb");
+
+    u32 version = WORLD_FILE_VERSION;
+    u16 width = WORLD_WIDTH;
+    u16 height = WORLD_HEIGHT;
+    fwrite("WRLD", 1, 4, file);
+    fwrite(&version, sizeof(version), 1, file);
+    fwrite(&world->seed, sizeof(world->seed), 1, file);
+    fwrite(&width, sizeof(width), 1, file);
+    fwrite(&height, sizeof(height), 1, file);
+
     for ( int i = 0; i < WORLD_WIDTH * WORLD_HEIGHT; i++ ) {
-        if ( world->tiles[i].effect ) {
-            SDL_DestroyTexture(world->tiles[i].effect);
-        }
+        u8 tile[2] = { world->tiles[i].terrain, world->tiles[i].variety };
+        fwrite(tile, sizeof(tile), 1, file);
+    }
+
+    u32 num_actors = world->actors->count;
+    fwrite(&num_actors, sizeof(num_actors), 1, file);
+
+    actor_t * actors = world->actors->data;
+    for ( u32 i = 0; i < num_actors; i++ ) {
+        u16 type = actors[i].type;
+        s16 z = actors[i].z;
+        fwrite(&type, sizeof(type), 1, file);
+        fwrite(&actors[i].pos.x, sizeof(actors[i].pos.x), 1, file);
+        fwrite(&actors[i].pos.y, sizeof(actors[i].pos.y), 1, file);
+        fwrite(&z, sizeof(z), 1, file);
     }
 
+    if ( ferror(file) ) {
+        Error("could not write %s", path);
+    }
+
+    fclose(file);
+}
+
+void DestroyWorld(world_t * world)
+{
+    StopChunkWorkers();
+    FreeTerrainCache(world);
+    FreeDrawList(world);
+    FreeCollisionIndex(world);
+    FreeActorResidency(world);
+    SDL_DestroyTexture(world->debug_map);
+    free(world->debug_map_pixels);
+
     FreeArray(world->actors);
     FreeArray(world->pending_actors);
+    FreeArray(world->actor_slots);
 
     free(world);
 }
@@ -17,47 +17,117 @@
 #include "mylib/sprite.h"
 #include "mylib/texture.h"
 
+#include <SDL_image.h>
+
 #define HORIZONTAL_NUM_TILES ((float)GAME_WIDTH / (float)TILE_SIZE)
 #define VERTICAL_NUM_TILES ((float)GAME_HEIGHT / (float)TILE_SIZE)
 
-void UpdateDebugMap(tile_t * tiles,  SDL_Texture ** debug_map, vec2_t camera)
-{
-    // TODO: add these as tile_t property, add tile definitions
-    static const SDL_Color layer_colors[] = {
-        { 0x00, 0x00,  160, 0xFF },
-        {   32,   32,  200, 0xFF },
-        //{ 0xD2, 0xC2, 0x90, 0xFF },
-        { 0x22, 0x8B, 0x22, 0xFF },
-        { 0x11, 0x60, 0x11, 0xFF },
-        {   80,   80,   90, 0xFF },
-        {  248,  248,  248, 0xFF },
-    };
+// Terrain colors for the debug map and saved terrain maps.
+// TODO: add these as tile_t property, add tile definitions
+static const SDL_Color terrain_map_colors[] = {
+    { 0x00, 0x00,  160, 0xFF },
+    {   32,   32,  200, 0xFF },
+    //{ 0xD2, 0xC2, 0x90, 0xFF },
+    { 0x22, 0x8B, 0x22, 0xFF },
+    { 0x11, 0x60, 0x11, 0xFF },
+    {   80,   80,   90, 0xFF },
+    {  248,  248,  248, 0xFF },
+};
+
+// Write a chunk's terrain colors into the debug map pixels. They're uploaded
+// the next time the map is shown.
+static void DrawDebugMapChunk(world_t * world, chunk_coord_t chunk)
+{
+    tile_coord_t corner = ChunkToTile(chunk);
+
+    for ( int y = corner.y; y < corner.y + CHUNK_SIZE; y++ ) {
+        SDL_Color * row = &world->debug_map_pixels[y * WORLD_WIDTH];
+
+        for ( int x = corner.x; x < corner.x + CHUNK_SIZE; x++ ) {
+            row[x] = terrain_map_colors[GetTile(world->tiles, x, y)->terrain];
+        }
+    }
+
+    world->debug_map_dirty[chunk.y][chunk.x] = true;
+}
+
+void UpdateDebugMap(world_t * world)
+{
+    const int pitch = WORLD_WIDTH * sizeof(*world->debug_map_pixels);
 
-    if ( *debug_map == NULL ) {
-        *debug_map = V_CreateTexture(WORLD_WIDTH, WORLD_HEIGHT);
+    if ( world->debug_map == NULL ) {
+        world->debug_map = SDL_CreateTexture
+        (   renderer,
+            SDL_PIXELFORMAT_RGBA32, // Same layout as SDL_Color.
+            SDL_TEXTUREACCESS_STREAMING,
+            WORLD_WIDTH,
+            WORLD_HEIGHT );
+        world->debug_map_pixels = malloc(WORLD_WIDTH * WORLD_HEIGHT * sizeof(*world->debug_map_pixels));
+
+        if ( world->debug_map == NULL || world->debug_map_pixels == NULL ) {
+            Error("could not create debug map: %s", SDL_GetError());
+        }
+
+        for ( int y = 0; y < WORLD_HEIGHT / CHUNK_SIZE; y++ ) {
+            for ( int x = 0; x < WORLD_WIDTH / CHUNK_SIZE; x++ ) {
+                DrawDebugMapChunk(world, (chunk_coord_t){ x, y });
+            }
+        }
+
+        SDL_UpdateTexture(world->debug_map, NULL, world->debug_map_pixels, pitch);
+        memset(world->debug_map_dirty, 0, sizeof(world->debug_map_dirty));
+        return;
     }
 
-    SDL_SetRenderTarget(renderer, *debug_map);
+    for ( int y = 0; y < WORLD_HEIGHT / CHUNK_SIZE; y++ ) {
+        for ( int x = 0; x < WORLD_WIDTH / CHUNK_SIZE; x++ ) {
+            if ( world->debug_map_dirty[y][x] ) {
+                SDL_Rect rect = {
+                    x * CHUNK_SIZE,
+                    y * CHUNK_SIZE,
+                    CHUNK_SIZE,
+                    CHUNK_SIZE
+                };
+                const SDL_Color * pixels = &world->debug_map_pixels[rect.y * WORLD_WIDTH + rect.x];
+
+                SDL_UpdateTexture(world->debug_map, &rect, pixels, pitch);
+                world->debug_map_dirty[y][x] = false;
+            }
+        }
+    }
+}
+
+void SaveTerrainMap(tile_t * tiles, const char * path)
+{
+    SDL_Surface * surface = SDL_CreateRGBSurfaceWithFormat
+    (   0,
+        WORLD_WIDTH,
+        WORLD_HEIGHT,
+        32,
+        SDL_PIXELFORMAT_RGBA32 );
+    if ( surface == NULL ) {
+        Error("could not create surface: %s", SDL_GetError());
+    }
 
     for ( int y = 0; y < WORLD_HEIGHT; y++ ) {
-        for ( int x = 0; x < WORLD_WIDTH; x++ ) {
-            tile_t * tile = GetTile(tiles, x, y);
+        u32 * row = (u32 *)((u8 *)surface->pixels + y * surface->pitch);
 
-            // render pixel to debug texture for this tile's terrain type
-            V_SetColor(layer_colors[tile->terrain]);
-            V_DrawPoint(x, y);
+        for ( int x = 0; x < WORLD_WIDTH; x++ ) {
+            SDL_Color color = terrain_map_colors[GetTile(tiles, x, y)->terrain];
+            row[x] = SDL_MapRGBA
+            (   surface->format,
+                color.r,
+                color.g,
+                color.b,
+                color.a );
         }
     }
 
-    V_SetGray(255);
-    SDL_Rect vis_rect = GetVisibleRect(camera);
-    vis_rect.x /= SCALED_TILE_SIZE;
-    vis_rect.y /= SCALED_TILE_SIZE;
-    vis_rect.w /= SCALED_TILE_SIZE;
-    vis_rect.h /= SCALED_TILE_SIZE;
-    V_DrawRect(&vis_rect);
+    if ( IMG_SavePNG(surface, path) != 0 ) {
+        Error("could not save %s: %s", path, SDL_GetError());
+    }
 
-    SDL_SetRenderTarget(renderer, NULL);
+    SDL_FreeSurface(surface);
 }
 
 // Determine the maximum point at which rect 'inner' can
@@ -74,53 +144,57 @@ static SDL_Point RectInRectMaxPoint
     return pt;
 }
 
-// Used by RenderGrassEffectTexture().
-// Render flowers n stuff onto effect texture.
-static void RenderGrassDecoration(sprite_id_t id, u8 sprite_variety)
+// Used by RasterizeGrassEffect().
+// Draw flowers n stuff onto effect surface.
+static void DrawGrassDecoration
+(   SDL_Surface * surface,
+    sprite_id_t id,
+    u8 sprite_variety,
+    rng_t * rng )
 {
     sprite_t * s = &sprites[id];
     SDL_Rect area = { .w = TILE_SIZE, .h = TILE_SIZE };
     SDL_Point max = RectInRectMaxPoint(&s->location, &area, 1);
 
     SDL_RendererFlip flip = SDL_FLIP_NONE;
-    if ( s->flip & SDL_FLIP_HORIZONTAL && Random(0, 1) == 1 ) {
+    if ( s->flip & SDL_FLIP_HORIZONTAL && RNGRandom(rng, 0, 1) == 1 ) {
         flip |= SDL_FLIP_HORIZONTAL;
     }
 
-    if ( s->flip & SDL_FLIP_VERTICAL && Random(0, 1) == 1 ) {
+    if ( s->flip & SDL_FLIP_VERTICAL && RNGRandom(rng, 0, 1) == 1 ) {
         flip |= SDL_FLIP_VERTICAL;
     }
 
-    DrawSprite
-    (   s,
-        sprite_variety % s->num_frames,
-        0,
-        Random(1, max.x),
-        Random(1, max.y),
-        1,
-        flip );
+    int x = RNGRandom(rng, 1, max.x);
+    int y = RNGRandom(rng, 1, max.y);
+    BlitSprite(s, sprite_variety % s->num_frames, 0, surface, x, y, flip);
 }
 
-void RenderGrassEffectTexture
-(   tile_t * tile,
-    tile_t ** adjacent_tiles,
-    int tile_x,
-    int tile_y )
+static void SetPixel(SDL_Surface * surface, int x, int y, SDL_Color color)
 {
-    tile->effect = V_CreateTexture(TILE_SIZE, TILE_SIZE);
-    SDL_SetTextureBlendMode(tile->effect, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderTarget(renderer, tile->effect);
-
-    V_SetRGBA(0, 0, 0, 0);
-    V_Clear();
+    u8 * pixel = (u8 *)surface->pixels + y * surface->pitch + x * 4;
+    pixel[0] = color.r;
+    pixel[1] = color.g;
+    pixel[2] = color.b;
+    pixel[3] = color.a;
+}
 
-    // Render moss.
+void RasterizeGrassEffect
+(   SDL_Surface * surface,
+    float noise_map[TILE_SIZE][TILE_SIZE],
+    u8 variety,
+    int edges,
+    rng_t * rng )
+{
+    static const SDL_Color dark_moss = { 78, 138, 36, 255 }; // darker green
+    static const SDL_Color light_moss = { 114, 201, 52, 255 }; // faintly lighter shade of same grass color
+    static const SDL_Color highlight = { 122, 214, 56, 255 };
 
-    float noise_map[TILE_SIZE][TILE_SIZE];
-    GetTileNoise(tile_x, tile_y, noise_map);
+    for ( int y = 0; y < TILE_SIZE; y++ ) {
+        memset((u8 *)surface->pixels + y * surface->pitch, 0, TILE_SIZE * 4);
+    }
 
-    // Set a unique seed for this tile ?
-    //SeedRandom(tile_y * WORLD_WIDTH + tile_x);
+    // Render moss.
 
     struct {
         int x;
@@ -129,134 +203,693 @@ void RenderGrassEffectTexture
     } moss_flowers[TILE_SIZE * TILE_SIZE];
     int num_moss_flowers = 0;
 
-    // ~0.4 ms:
-//    SetRGBA(93, 163, 42, 255); // darker shade of same grass color
-//    SetRGBA(114, 201, 52, 255); // faintly lighter shade of same grass color
     for ( int py = 0; py < TILE_SIZE; py++ ) {
         for ( int px = 0; px < TILE_SIZE; px++ ) {
-//            int wx = tile_x * 16 + px; // world pixel coord
-//            int wy = tile_y * 16 + py;
-//            noise_map[py][px] = Noise2(wx, wy, 1.0f, 0.01f, 8, 1.0f, 0.5f, 2.5f);
-//            SeedRandom(wx * wy); // TODO: more than one prng
-
-            if ( noise_map[py][px] > 0.2f ) { //}|| (noise > 0.05f && Random(0, 3) == 0) ) {
-                V_SetRGBA(78, 138, 36, 255); // darker green
-                V_DrawPoint(px, py);
+            if ( noise_map[py][px] > 0.2f ) {
+                SetPixel(surface, px, py, dark_moss);
             } else if ( noise_map[py][px] > 0.1 ) {
-                V_SetRGBA(114, 201, 52, 255); // faintly lighter shade of same grass color
-                V_DrawPoint(px, py);
+                SetPixel(surface, px, py, light_moss);
             }
 
             if ( noise_map[py][px] > 0.7f ) {
-                if ( Random(0, 15) == 15 ) {
+                if ( RNGRandom(rng, 0, 15) == 15 ) {
                     moss_flowers[num_moss_flowers].x = px;
                     moss_flowers[num_moss_flowers].y = py;
                     moss_flowers[num_moss_flowers].blue = false;
                     num_moss_flowers++;
                 }
-            } else if ( noise_map[py][px] > 0.45f && Random(0, 20) == 20 ) {
+            } else if ( noise_map[py][px] > 0.45f && RNGRandom(rng, 0, 20) == 20 ) {
                 moss_flowers[num_moss_flowers].x = px;
                 moss_flowers[num_moss_flowers].y = py;
                 moss_flowers[num_moss_flowers].blue = true;
                 num_moss_flowers++;
             }
-
         }
     }
 
     // Render tiny moss flowers.
-#if 0
-    for ( int py = 0; py < TILE_SIZE; py++ ) {
-        for ( int px = 0; px < TILE_SIZE; px++ ) {
-            if ( noise_map[py][px] > 0.7f ) {
-                if ( Random(0, 15) == 15 ) {
-                    DrawSprite(&sprites[SPRITE_TINY_YELLOW_FLOWER], px, py, 0, 1);
-                }
-            } else if ( noise_map[py][px] > 0.45f && Random(0, 20) == 20 ) {
-                DrawSprite(&sprites[SPRITE_TINY_BLUE_FLOWER], px, py, 0, 1);
-            }
-        }
-    }
-#endif
     for ( int i = 0; i < num_moss_flowers; i++ ) {
         sprite_id_t id =
         moss_flowers[i].blue ? SPRITE_TINY_BLUE_FLOWER : SPRITE_TINY_YELLOW_FLOWER;
-        //DrawSprite(&sprites[id], moss_flowers[i].x, moss_flowers[i].y, 0, 1);
-        DrawSprite(&sprites[id], 0, 0, moss_flowers[i].x, moss_flowers[i].y, 1, 0);
+        BlitSprite(&sprites[id], 0, 0, surface, moss_flowers[i].x, moss_flowers[i].y, 0);
     }
 
-
     // Sprinkle some foliage.
     // Most tiles have grass, occasionally a flower.
-    if ( Random(0, 1) == 1 ) {
-        if ( Random(0, 12) == 12 ) {
-            if ( Random(0, 1) == 1 ) {
-                RenderGrassDecoration(SPRITE_PLUS_FLOWER, tile->variety);
+    if ( RNGRandom(rng, 0, 1) == 1 ) {
+        if ( RNGRandom(rng, 0, 12) == 12 ) {
+            if ( RNGRandom(rng, 0, 1) == 1 ) {
+                DrawGrassDecoration(surface, SPRITE_PLUS_FLOWER, variety, rng);
             } else {
-                RenderGrassDecoration(SPRITE_WHITE_FLOWERS, tile->variety);
+                DrawGrassDecoration(surface, SPRITE_WHITE_FLOWERS, variety, rng);
             }
         } else {
-            RenderGrassDecoration(SPRITE_GRASS_BLADES, tile->variety);
+            DrawGrassDecoration(surface, SPRITE_GRASS_BLADES, variety, rng);
         }
     }
 
     // Draw highlights at water edges.
-    V_SetRGBA(122, 214, 56, 255);
-    if ( adjacent_tiles[NORTH]->terrain <= TERRAIN_SHALLOW_WATER ) {
-        SDL_RenderDrawLine(renderer, 0, 0, TILE_SIZE + 1, 0);
+    for ( int i = 0; i < TILE_SIZE; i++ ) {
+        if ( edges & EFFECT_EDGE_NORTH ) {
+            SetPixel(surface, i, 0, highlight);
+        }
+
+        if ( edges & EFFECT_EDGE_WEST ) {
+            SetPixel(surface, 0, i, highlight);
+        }
+
+        if ( edges & EFFECT_EDGE_EAST ) {
+            SetPixel(surface, TILE_SIZE - 1, i, highlight);
+        }
     }
+}
+
+static bool IsWater(tile_t * tile)
+{
+    return tile && tile->terrain <= TERRAIN_SHALLOW_WATER;
+}
 
-    if ( adjacent_tiles[WEST]->terrain <= TERRAIN_SHALLOW_WATER ) {
-        SDL_RenderDrawLine(renderer, 0, 0, 0, TILE_SIZE);
+static int GrassEdgeMask(tile_t ** adjacent_tiles)
+{
+    int edges = 0;
+
+    if ( IsWater(adjacent_tiles[NORTH]) ) {
+        edges |= EFFECT_EDGE_NORTH;
     }
 
-    if ( adjacent_tiles[EAST]->terrain <= TERRAIN_SHALLOW_WATER ) {
-        SDL_RenderDrawLine(renderer, TILE_SIZE - 1, 0, TILE_SIZE - 1, TILE_SIZE - 1);
+    if ( IsWater(adjacent_tiles[WEST]) ) {
+        edges |= EFFECT_EDGE_WEST;
     }
 
-    SDL_SetRenderTarget(renderer, NULL);
+    if ( IsWater(adjacent_tiles[EAST]) ) {
+        edges |= EFFECT_EDGE_EAST;
+    }
+
+    return edges;
 }
 
-static void RenderGrass
-(   tile_t * tile,
-    tile_t ** adjacent_tiles,
-    tile_coord_t tile_coord,
-    SDL_Rect * dst )
-{
-    SetSpriteColorMod(&sprites[SPRITE_GRASS], tile->lighting);
-    //DrawSprite(&sprites[SPRITE_GRASS], dst->x, dst->y, tile->variety, DRAW_SCALE);
-    sprite_t * sprite = &sprites[SPRITE_GRASS];
-
-    DrawSprite
-    (   sprite,
-        tile->variety % sprite->num_frames,
-        0,
-        dst->x,
-        dst->y,
-        DRAW_SCALE,
+// A chunk's grass effects are rasterized into one surface, which is uploaded
+// to the effect texture and drawn over the chunk's slot when it's baked.
+static SDL_Surface * chunk_effects;
+static SDL_Texture * chunk_effects_texture;
+static bool chunk_has_effects;
+
+// The surface a single effect is rasterized into before it's copied.
+static SDL_Surface * EffectSurface(void)
+{
+    static SDL_Surface * surface;
+
+    if ( surface == NULL ) {
+        surface = SDL_CreateRGBSurfaceWithFormat
+        (   0,
+            TILE_SIZE,
+            TILE_SIZE,
+            32,
+            SDL_PIXELFORMAT_RGBA32 );
+        if ( surface == NULL ) {
+            Error("could not create surface: %s", SDL_GetError());
+        }
+    }
+
+    return surface;
+}
+
+static void ClearChunkEffects(void)
+{
+    if ( chunk_effects == NULL ) {
+        chunk_effects = SDL_CreateRGBSurfaceWithFormat
+        (   0,
+            CHUNK_SIZE * TILE_SIZE,
+            CHUNK_SIZE * TILE_SIZE,
+            32,
+            SDL_PIXELFORMAT_RGBA32 );
+        if ( chunk_effects == NULL ) {
+            Error("could not create surface: %s", SDL_GetError());
+        }
+    }
+
+    memset(chunk_effects->pixels, 0, chunk_effects->h * chunk_effects->pitch);
+    chunk_has_effects = false;
+}
+
+// Upload the chunk's effects and queue them over `dst`.
+static void QueueChunkEffects(const SDL_Rect * dst)
+{
+    if ( !chunk_has_effects ) {
+        return;
+    }
+
+    if ( chunk_effects_texture == NULL ) {
+        chunk_effects_texture = SDL_CreateTexture
+        (   renderer,
+            SDL_PIXELFORMAT_RGBA32,
+            SDL_TEXTUREACCESS_STATIC,
+            chunk_effects->w,
+            chunk_effects->h );
+        if ( chunk_effects_texture == NULL ) {
+            Error("could not create effect texture: %s", SDL_GetError());
+        }
+
+        SDL_SetTextureBlendMode(chunk_effects_texture, SDL_BLENDMODE_BLEND);
+    }
+
+    SDL_UpdateTexture
+    (   chunk_effects_texture,
+        NULL,
+        chunk_effects->pixels,
+        chunk_effects->pitch );
+
+    SDL_Rect src = { 0, 0, chunk_effects->w, chunk_effects->h };
+    QueueTexture
+    (   chunk_effects_texture,
+        &src,
+        dst,
+        (SDL_Color){ 255, 255, 255, 255 },
+        LAYER_TERRAIN_EFFECTS,
         0 );
+}
+
+// Effects use the RNG streams after the chunks' generation streams, one per
+// tile.
+#define EFFECT_RNG_STREAM(x, y) \
+    ((WORLD_WIDTH / CHUNK_SIZE) * (WORLD_HEIGHT / CHUNK_SIZE) + (y) * WORLD_WIDTH + (x))
+
+// Copy a rasterized effect into its tile's place in the chunk's effects.
+static void CopyChunkEffect
+(   const u8 * pixels,
+    int pitch,
+    int tile_x,
+    int tile_y )
+{
+    int x = (tile_x % CHUNK_SIZE) * TILE_SIZE;
+    int y = (tile_y % CHUNK_SIZE) * TILE_SIZE;
 
-    // Generate effect texture for this tile if needed.
-    if ( tile->effect == NULL ) {
-        RenderGrassEffectTexture(tile, adjacent_tiles, tile_coord.x, tile_coord.y);
+    for ( int row = 0; row < TILE_SIZE; row++ ) {
+        memcpy
+        (   (u8 *)chunk_effects->pixels + (y + row) * chunk_effects->pitch + x * 4,
+            pixels + row * pitch,
+            TILE_SIZE * 4 );
     }
 
-    // overlay the effect texture
-    SDL_SetTextureColorMod
-    (   tile->effect,
-        tile->lighting.x,
-        tile->lighting.y,
-        tile->lighting.z );
+    chunk_has_effects = true;
+}
+
+// The grass_effect_variants pool: for every edge mask, variant i looks like
+// the effect for tile (i, 0) would. Rasterized once per world, then baking a
+// chunk's effects is just copying.
+struct effect_variants {
+    u8 pixels[NUM_EFFECT_EDGE_MASKS][NUM_EFFECT_VARIANTS][TILE_SIZE * TILE_SIZE * 4];
+};
+
+bool grass_effect_variants;
+
+static effect_variants_t * CreateGrassEffectVariants(world_t * world)
+{
+    effect_variants_t * variants = malloc(sizeof(*variants));
+    if ( variants == NULL ) {
+        Error("could not allocate effect variants");
+    }
+
+    SDL_Surface * surface = EffectSurface();
+    for ( int i = 0; i < NUM_EFFECT_VARIANTS; i++ ) {
+        float noise_map[TILE_SIZE][TILE_SIZE];
+        ComputeTileNoise(world, i, 0, noise_map);
+
+        for ( int edges = 0; edges < NUM_EFFECT_EDGE_MASKS; edges++ ) {
+            rng_t rng;
+            InitRNG(&rng, world->seed, EFFECT_RNG_STREAM(i, 0));
+            RasterizeGrassEffect(surface, noise_map, i, edges, &rng);
+
+            u8 * pixels = variants->pixels[edges][i];
+            for ( int row = 0; row < TILE_SIZE; row++ ) {
+                memcpy
+                (   pixels + row * TILE_SIZE * 4,
+                    (u8 *)surface->pixels + row * surface->pitch,
+                    TILE_SIZE * 4 );
+            }
+        }
+    }
 
-    V_DrawTexture(tile->effect, NULL, dst);
+    return variants;
 }
 
-static void RenderVisibleTerrain(world_t * world)
+// Rasterize a grass tile's effect (moss, flowers, and water edge highlights)
+// into its place in the chunk's effects, or copy in its variant from the pool.
+static void RenderGrassEffect
+(   world_t * world,
+    tile_t * tile,
+    tile_t ** adjacent_tiles,
+    int tile_x,
+    int tile_y )
 {
-    SDL_Rect visible_rect = GetVisibleRect(world->camera);
+    rng_t rng;
+    InitRNG(&rng, world->seed, EFFECT_RNG_STREAM(tile_x, tile_y));
+
+    if ( grass_effect_variants ) {
+        if ( world->effect_variants == NULL ) {
+            world->effect_variants = CreateGrassEffectVariants(world);
+        }
+
+        int i = RNGRandom(&rng, 0, NUM_EFFECT_VARIANTS - 1);
+        int edges = GrassEdgeMask(adjacent_tiles);
+        CopyChunkEffect
+        (   world->effect_variants->pixels[edges][i],
+            TILE_SIZE * 4,
+            tile_x,
+            tile_y );
+        return;
+    }
+
+    float noise_map[TILE_SIZE][TILE_SIZE];
+    GetTileNoise(tile_x, tile_y, noise_map);
+
+    SDL_Surface * surface = EffectSurface();
+    RasterizeGrassEffect
+    (   surface,
+        noise_map,
+        tile->variety,
+        GrassEdgeMask(adjacent_tiles),
+        &rng );
+    CopyChunkEffect(surface->pixels, surface->pitch, tile_x, tile_y);
+}
+
+// Queue a tile, unlit and unscaled, at dst.
+static void RenderTile(world_t * world, tile_coord_t tile_coord, SDL_Rect * dst)
+{
+    static const vec3_t unlit = { 255, 255, 255 };
+    tile_t * tile = GetTile(world->tiles, tile_coord.x, tile_coord.y);
+
+    tile_t * adjacent_tiles[NUM_DIRECTIONS];
+    GetAdjacentTiles(tile_coord.x, tile_coord.y, world->tiles, adjacent_tiles);
+
+    switch ( tile->terrain ) {
+        case TERRAIN_DEEP_WATER:
+            // TODO: render deep water
+        case TERRAIN_SHALLOW_WATER: {
+            sprite_t * sprite;
+
+            if ( adjacent_tiles[NORTH]
+                && adjacent_tiles[NORTH]->terrain != TERRAIN_SHALLOW_WATER
+                && adjacent_tiles[NORTH]->terrain != TERRAIN_DEEP_WATER )
+            {
+                sprite = &sprites[SPRITE_SHALLOW_WATER_EDGE];
+            } else {
+                sprite = &sprites[SPRITE_SHALLOW_WATER];
+            }
+
+            QueueSprite(sprite, 0, 0, dst->x, dst->y, 1, 0, unlit, LAYER_TERRAIN, 0);
+            break;
+        }
+        case TERRAIN_GRASS:
+        case TERRAIN_FOREST:
+        case TERRAIN_DARK_FOREST: {
+            sprite_t * sprite = &sprites[SPRITE_GRASS];
+            int cell = tile->variety % sprite->num_frames;
+            QueueSprite(sprite, cell, 0, dst->x, dst->y, 1, 0, unlit, LAYER_TERRAIN, 0);
+            RenderGrassEffect
+            (   world,
+                tile,
+                adjacent_tiles,
+                tile_coord.x,
+                tile_coord.y );
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+#pragma mark - CHUNK TERRAIN CACHE
+
+// Each visible chunk's terrain is drawn once, unlit, into a slot in a terrain
+// page, a texture with room for TERRAIN_PAGE_SLOTS chunks. A chunk is only
+// redrawn when its tiles change. Chunks keep their slot index, so finding
+// one is a lookup. Free slots are taken in order, so pages are created one at
+// a time as they fill, up to as many as terrain_cache_budget allows. After
+// that, the least recently drawn chunk's slot is reused for chunks coming
+// into view. An evicted chunk is baked again if it comes back into view, and
+// looks the same: everything drawn depends only on its tiles, the world seed,
+// and tile coordinates.
+
+#define CHUNK_PIXELS (CHUNK_SIZE * TILE_SIZE)
+#define TERRAIN_PAGE_SIZE (TERRAIN_PAGE_COLUMNS * CHUNK_PIXELS)
+#define TERRAIN_PAGE_BYTES (TERRAIN_PAGE_SIZE * TERRAIN_PAGE_SIZE * 4)
+
+// Most chunks that can be partly on screen at once.
+#define MAX_VISIBLE_CHUNKS \
+    ((GAME_WIDTH / (CHUNK_SIZE * SCALED_TILE_SIZE) + 2) \
+    * (GAME_HEIGHT / (CHUNK_SIZE * SCALED_TILE_SIZE) + 2))
+
+size_t terrain_cache_budget = TERRAIN_CACHE_DEFAULT_BUDGET;
+
+static int terrain_frame; // Stamps slots as they're drawn.
+
+static SDL_Rect TerrainSlotRect(int slot)
+{
+    int page_slot = slot % TERRAIN_PAGE_SLOTS;
+
+    SDL_Rect rect = {
+        .x = (page_slot % TERRAIN_PAGE_COLUMNS) * CHUNK_PIXELS,
+        .y = (page_slot / TERRAIN_PAGE_COLUMNS) * CHUNK_PIXELS,
+        .w = CHUNK_PIXELS,
+        .h = CHUNK_PIXELS
+    };
+
+    return rect;
+}
+
+// Get the page `slot` is in, creating it if this is its first use.
+static SDL_Texture * TerrainPage(world_t * world, int slot)
+{
+    SDL_Texture ** page = &world->terrain_pages[slot / TERRAIN_PAGE_SLOTS];
+
+    if ( *page == NULL ) {
+        *page = SDL_CreateTexture
+        (   renderer,
+            SDL_PIXELFORMAT_RGBA32,
+            SDL_TEXTUREACCESS_TARGET,
+            TERRAIN_PAGE_SIZE,
+            TERRAIN_PAGE_SIZE );
+        if ( *page == NULL ) {
+            Error("could not create terrain page: %s", SDL_GetError());
+        }
+
+        SDL_SetTextureBlendMode(*page, SDL_BLENDMODE_BLEND);
+        world->terrain_stats.resident_bytes += TERRAIN_PAGE_BYTES;
+    }
+
+    return *page;
+}
+
+void InitTerrainCache(world_t * world)
+{
+    for ( int y = 0; y < WORLD_HEIGHT / CHUNK_SIZE; y++ ) {
+        for ( int x = 0; x < WORLD_WIDTH / CHUNK_SIZE; x++ ) {
+            world->terrain_slots[y][x] = -1;
+        }
+    }
+
+    const int min_pages
+        = (MAX_VISIBLE_CHUNKS + TERRAIN_PAGE_SLOTS - 1) / TERRAIN_PAGE_SLOTS;
+    size_t pages = terrain_cache_budget / TERRAIN_PAGE_BYTES;
+    pages = MIN(pages, MAX_TERRAIN_PAGES);
+    world->terrain_capacity = MAX((int)pages, min_pages) * TERRAIN_PAGE_SLOTS;
+
+    // Pushed last to first, so slot 0 is taken first.
+    world->num_free_terrain_slots = 0;
+    for ( int i = world->terrain_capacity - 1; i >= 0; i-- ) {
+        world->free_terrain_slots[world->num_free_terrain_slots++] = i;
+    }
+}
+
+// Take a free slot, or the least recently drawn chunk's.
+static int TakeTerrainSlot(world_t * world)
+{
+    if ( world->num_free_terrain_slots > 0 ) {
+        return world->free_terrain_slots[--world->num_free_terrain_slots];
+    }
+
+    int oldest = 0;
+    for ( int i = 1; i < world->terrain_capacity; i++ ) {
+        if ( world->terrain_cache[i].last_drawn
+            < world->terrain_cache[oldest].last_drawn )
+        {
+            oldest = i;
+        }
+    }
+
+    chunk_coord_t evicted = world->terrain_cache[oldest].chunk;
+    world->terrain_slots[evicted.y][evicted.x] = -1;
+    world->terrain_stats.evictions++;
+
+    return oldest;
+}
+
+// Get `chunk`'s slot, taking one for it if it doesn't have one.
+static int GetTerrainSlot(world_t * world, chunk_coord_t chunk)
+{
+    int * index = &world->terrain_slots[chunk.y][chunk.x];
+
+    if ( *index != -1 ) {
+        return *index;
+    }
+
+    *index = TakeTerrainSlot(world);
+    terrain_slot_t * slot = &world->terrain_cache[*index];
+    slot->chunk = chunk;
+    slot->dirty = true;
+
+    // Texture coordinates for this chunk's tiles have changed.
+    world->terrain_mesh.dirty = true;
+
+    return *index;
+}
+
+static void RenderChunkTerrain(world_t * world, int slot)
+{
+    terrain_slot_t * terrain_slot = &world->terrain_cache[slot];
+    SDL_Rect slot_rect = TerrainSlotRect(slot);
+
+    SDL_SetRenderTarget(renderer, TerrainPage(world, slot));
+    V_SetRGB(0, 0, 0);
+    V_FillRect(&slot_rect);
+
+    tile_coord_t corner = ChunkToTile(terrain_slot->chunk);
+    SDL_Rect dst = { .w = TILE_SIZE, .h = TILE_SIZE };
+    ClearChunkEffects();
+    if ( !grass_effect_variants ) { // Variants don't need any noise.
+        ComputeChunkNoise(world, terrain_slot->chunk);
+    }
+
+    for ( int y = 0; y < CHUNK_SIZE; y++ ) {
+        for ( int x = 0; x < CHUNK_SIZE; x++ ) {
+            dst.x = slot_rect.x + x * TILE_SIZE;
+            dst.y = slot_rect.y + y * TILE_SIZE;
+            RenderTile(world, (tile_coord_t){ corner.x + x, corner.y + y }, &dst);
+        }
+    }
+
+    QueueChunkEffects(&slot_rect);
+    FlushSprites();
+    SDL_SetRenderTarget(renderer, NULL);
+    terrain_slot->dirty = false;
+}
+
+void InvalidateChunkTerrain(world_t * world, chunk_coord_t chunk)
+{
+    // Neighbors' edge tiles, and their grass effects' water highlights, look
+    // at this chunk's tiles too.
+    static const SDL_Point offsets[] = {
+        { 0, 0 }, { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 }
+    };
+
+    for ( int i = 0; i < (int)ARRAY_SIZE(offsets); i++ ) {
+        int x = chunk.x + offsets[i].x;
+        int y = chunk.y + offsets[i].y;
+
+        if ( x < 0 || x >= WORLD_WIDTH / CHUNK_SIZE
+            || y < 0 || y >= WORLD_HEIGHT / CHUNK_SIZE )
+        {
+            continue;
+        }
+
+        int slot = world->terrain_slots[y][x];
+        if ( slot != -1 ) {
+            world->terrain_cache[slot].dirty = true;
+        }
+    }
+
+    // Until the map has been shown, there are no pixels to keep current.
+    if ( world->debug_map_pixels ) {
+        DrawDebugMapChunk(world, chunk);
+    }
+}
+
+void InvalidateAllTerrain(world_t * world)
+{
+    for ( int i = 0; i < world->terrain_capacity; i++ ) {
+        world->terrain_cache[i].dirty = true;
+    }
+}
+
+void FreeTerrainCache(world_t * world)
+{
+    for ( int i = 0; i < MAX_TERRAIN_PAGES; i++ ) {
+        if ( world->terrain_pages[i] ) {
+            SDL_DestroyTexture(world->terrain_pages[i]);
+            world->terrain_pages[i] = NULL;
+        }
+    }
+
+    free(world->effect_variants);
+    world->effect_variants = NULL;
+
+    memset(world->terrain_cache, 0, sizeof(world->terrain_cache));
+    memset(&world->terrain_stats, 0, sizeof(world->terrain_stats));
+    InitTerrainCache(world);
+    world->terrain_mesh.dirty = true;
+}
+
+#pragma mark - TERRAIN MESH
+
+// All visible terrain is drawn with one SDL_RenderGeometry per terrain page in
+// use: a quad per tile, textured from the tile's chunk slot, with the quads
+// grouped by page so each page is bound once. The quads are only rebuilt when
+// the visible tile range or the chunk slots change. Otherwise they're just
+// moved by however far the camera has scrolled.
+//
+// Vertex colors are the tiles' lighting, averaged at each corner, so light
+// blends smoothly from tile to tile.
+
+static void BuildTerrainMesh
+(   world_t * world,
+    SDL_Point min,
+    SDL_Point max,
+    SDL_Point origin )
+{
+    terrain_mesh_t * mesh = &world->terrain_mesh;
+    SDL_Vertex * v = mesh->vertices;
+    const float uv_scale = 1.0f / TERRAIN_PAGE_SIZE;
+    u8 tile_pages[MAX_VISIBLE_TILES];
+
+    mesh->num_tiles = 0;
+    memset(mesh->page_tiles, 0, sizeof(mesh->page_tiles));
+    for ( int y = min.y; y <= max.y; y++ ) {
+        for ( int x = min.x; x <= max.x; x++ ) {
+            chunk_coord_t chunk = TileToChunk((tile_coord_t){ x, y });
+            int slot = GetTerrainSlot(world, chunk);
+            SDL_Rect slot_rect = TerrainSlotRect(slot);
+
+            float left = x * SCALED_TILE_SIZE - origin.x;
+            float top = y * SCALED_TILE_SIZE - origin.y;
+            float tex_x = (slot_rect.x + (x % CHUNK_SIZE) * TILE_SIZE) * uv_scale;
+            float tex_y = (slot_rect.y + (y % CHUNK_SIZE) * TILE_SIZE) * uv_scale;
+            const float size = SCALED_TILE_SIZE;
+            const float uv_size = TILE_SIZE * uv_scale;
+
+            // top left, top right, bottom left, bottom right
+            v[0].position = (SDL_FPoint){ left, top };
+            v[1].position = (SDL_FPoint){ left + size, top };
+            v[2].position = (SDL_FPoint){ left, top + size };
+            v[3].position = (SDL_FPoint){ left + size, top + size };
+            v[0].tex_coord = (SDL_FPoint){ tex_x, tex_y };
+            v[1].tex_coord = (SDL_FPoint){ tex_x + uv_size, tex_y };
+            v[2].tex_coord = (SDL_FPoint){ tex_x, tex_y + uv_size };
+            v[3].tex_coord = (SDL_FPoint){ tex_x + uv_size, tex_y + uv_size };
+
+            tile_pages[mesh->num_tiles] = slot / TERRAIN_PAGE_SLOTS;
+            mesh->page_tiles[slot / TERRAIN_PAGE_SLOTS]++;
+            v += 4;
+            mesh->num_tiles++;
+        }
+    }
+
+    // Two triangles per quad, with each page's quads together. The vertices
+    // stay in tile order for lighting.
+    int next_quad[MAX_TERRAIN_PAGES];
+    int first_quad = 0;
+    for ( int page = 0; page < MAX_TERRAIN_PAGES; page++ ) {
+        next_quad[page] = first_quad;
+        first_quad += mesh->page_tiles[page];
+    }
+
+    for ( int i = 0; i < mesh->num_tiles; i++ ) {
+        int * quad = &mesh->indices[next_quad[tile_pages[i]]++ * 6];
+        int first = i * 4;
+        quad[0] = first + 0;
+        quad[1] = first + 1;
+        quad[2] = first + 2;
+        quad[3] = first + 2;
+        quad[4] = first + 1;
+        quad[5] = first + 3;
+    }
+
+    mesh->min = min;
+    mesh->max = max;
+    mesh->origin = origin;
+    mesh->dirty = false;
+    mesh->unlit = true;
+}
+
+static void MoveTerrainMesh(terrain_mesh_t * mesh, SDL_Point origin)
+{
+    float dx = mesh->origin.x - origin.x;
+    float dy = mesh->origin.y - origin.y;
 
+    for ( int i = 0; i < mesh->num_tiles * 4; i++ ) {
+        mesh->vertices[i].position.x += dx;
+        mesh->vertices[i].position.y += dy;
+    }
+
+    mesh->origin = origin;
+}
+
+static SDL_Color CornerLighting(world_t * world, int x, int y)
+{
+    vec3_t sum = { 0 };
+    int count = 0;
+
+    // The (up to) four tiles touching the top left corner of tile x, y.
+    for ( int ty = y - 1; ty <= y; ty++ ) {
+        for ( int tx = x - 1; tx <= x; tx++ ) {
+            tile_t * tile = GetTile(world->tiles, tx, ty);
+            if ( tile ) {
+                sum.x += tile->lighting.x;
+                sum.y += tile->lighting.y;
+                sum.z += tile->lighting.z;
+                count++;
+            }
+        }
+    }
+
+    SDL_Color color = {
+        sum.x / count,
+        sum.y / count,
+        sum.z / count,
+        255
+    };
+
+    return color;
+}
+
+static void LightTerrainMesh(world_t * world)
+{
+    terrain_mesh_t * mesh = &world->terrain_mesh;
+    int width = mesh->max.x - mesh->min.x + 1;
+    int height = mesh->max.y - mesh->min.y + 1;
+
+    // Two rows of corners at a time.
+    SDL_Color corners[2][GAME_WIDTH / SCALED_TILE_SIZE + 3];
+    for ( int x = 0; x <= width; x++ ) {
+        corners[0][x] = CornerLighting(world, mesh->min.x + x, mesh->min.y);
+    }
+
+    SDL_Vertex * v = mesh->vertices;
+    for ( int y = 0; y < height; y++ ) {
+        SDL_Color * top = corners[y % 2];
+        SDL_Color * bottom = corners[(y + 1) % 2];
+
+        for ( int x = 0; x <= width; x++ ) {
+            bottom[x] = CornerLighting(world, mesh->min.x + x, mesh->min.y + y + 1);
+        }
+
+        for ( int x = 0; x < width; x++ ) {
+            v[0].color = top[x];
+            v[1].color = top[x + 1];
+            v[2].color = bottom[x];
+            v[3].color = bottom[x + 1];
+            v += 4;
+        }
+    }
+
+    mesh->unlit = false;
+}
+
+// Debug overlays for the visible tiles.
+static void RenderTileDebugInfo(world_t * world)
+{
+    SDL_Rect visible_rect = GetVisibleRect(world->camera);
     SDL_Rect dst = { .w = SCALED_TILE_SIZE, .h = SCALED_TILE_SIZE, };
-    SDL_Rect src = { .w = TILE_SIZE, .h = TILE_SIZE };
 
     SDL_Point min, max;
     GetVisibleTileRange(world, &min, &max);
@@ -264,44 +897,8 @@ static void RenderVisibleTerrain(world_t * world)
     tile_coord_t tile_coord;
     for ( tile_coord.y = min.y; tile_coord.y <= max.y; tile_coord.y++ ) {
         for ( tile_coord.x = min.x; tile_coord.x <= max.x; tile_coord.x++ ) {
-            tile_t * tile = GetTile(world->tiles, tile_coord.x, tile_coord.y);
-
-            tile_t * adjacent_tiles[NUM_DIRECTIONS];
-            GetAdjacentTiles(tile_coord.x, tile_coord.y, world->tiles, adjacent_tiles);
-
-            src.x = TILE_SIZE * (tile->variety % 4); // TODO: #define 4
             dst.x = tile_coord.x * SCALED_TILE_SIZE - visible_rect.x;
             dst.y = tile_coord.y * SCALED_TILE_SIZE - visible_rect.y;
-//            dst.x /= DRAW_SCALE; dst.x *= DRAW_SCALE;
-//            dst.y /= DRAW_SCALE; dst.y *= DRAW_SCALE;
-
-            switch ( tile->terrain ) {
-                case TERRAIN_DEEP_WATER:
-                    // TODO: render deep water
-                case TERRAIN_SHALLOW_WATER: {
-                    sprite_t * sprite;
-
-                    if ( adjacent_tiles[NORTH]
-                        && adjacent_tiles[NORTH]->terrain != TERRAIN_SHALLOW_WATER
-                        && adjacent_tiles[NORTH]->terrain != TERRAIN_DEEP_WATER )
-                    {
-                        sprite = &sprites[SPRITE_SHALLOW_WATER_EDGE];
-                    } else {
-                        sprite = &sprites[SPRITE_SHALLOW_WATER];
-                    }
-
-                    SetSpriteColorMod(sprite, tile->lighting);
-                    DrawSprite(sprite, 0, 0, dst.x, dst.y, DRAW_SCALE, 0);
-                    break;
-                }
-                case TERRAIN_GRASS:
-                case TERRAIN_FOREST:
-                case TERRAIN_DARK_FOREST:
-                    RenderGrass(tile, adjacent_tiles, tile_coord, &dst);
-                    break;
-                default:
-                    break;
-            }
 
             // debug: highlight tile under mouse
             if (show_debug_info
@@ -317,52 +914,301 @@ static void RenderVisibleTerrain(world_t * world)
                 corner_dot.w = corner_dot.h = DRAW_SCALE;
                 V_FillRect(&corner_dot);
             }
+        }
+    }
+}
 
-            dst.x += TILE_SIZE;
+static void RenderVisibleTerrain(world_t * world)
+{
+    terrain_frame++;
+
+    SDL_Rect visible_rect = GetVisibleRect(world->camera);
+    SDL_Point origin = { visible_rect.x, visible_rect.y };
+
+    SDL_Point min, max;
+    GetVisibleTileRange(world, &min, &max);
+    min.x = MAX(min.x, 0);
+    min.y = MAX(min.y, 0);
+    max.x = MIN(max.x, WORLD_WIDTH - 1);
+    max.y = MIN(max.y, WORLD_HEIGHT - 1);
+
+    // Get every visible chunk into the terrain pages.
+    chunk_coord_t min_chunk = TileToChunk((tile_coord_t){ min.x, min.y });
+    chunk_coord_t max_chunk = TileToChunk((tile_coord_t){ max.x, max.y });
+    chunk_coord_t chunk;
+    for ( chunk.y = min_chunk.y; chunk.y <= max_chunk.y; chunk.y++ ) {
+        for ( chunk.x = min_chunk.x; chunk.x <= max_chunk.x; chunk.x++ ) {
+            int slot = GetTerrainSlot(world, chunk);
+            if ( world->terrain_cache[slot].dirty ) {
+                RenderChunkTerrain(world, slot);
+                world->terrain_stats.misses++;
+            } else {
+                world->terrain_stats.hits++;
+            }
+            world->terrain_cache[slot].last_drawn = terrain_frame;
         }
+    }
 
-        dst.y += TILE_SIZE;
+    terrain_mesh_t * mesh = &world->terrain_mesh;
+    if ( mesh->dirty
+        || min.x != mesh->min.x || min.y != mesh->min.y
+        || max.x != mesh->max.x || max.y != mesh->max.y )
+    {
+        BuildTerrainMesh(world, min, max, origin);
+    } else if ( origin.x != mesh->origin.x || origin.y != mesh->origin.y ) {
+        MoveTerrainMesh(mesh, origin);
+    }
+
+    if ( mesh->unlit ) {
+        LightTerrainMesh(world);
+    }
+
+    const int * indices = mesh->indices;
+    for ( int page = 0; page < MAX_TERRAIN_PAGES; page++ ) {
+        int count = mesh->page_tiles[page];
+        if ( count == 0 ) {
+            continue;
+        }
+
+        V_DrawGeometry
+        (   world->terrain_pages[page],
+            mesh->vertices,
+            mesh->num_tiles * 4,
+            indices,
+            count * 6 );
+        indices += count * 6;
+    }
+
+    if ( show_debug_info || show_geometry ) {
+        RenderTileDebugInfo(world);
     }
 }
 
-void RenderVisibleActors(world_t * world)
+#pragma mark - DRAW LIST
+
+// Chunks whose props might be visible: those in view plus one all around,
+// since sprites reach outside their actor's chunk.
+#define DRAW_LIST_CHUNKS_X (GAME_WIDTH / (CHUNK_SIZE * SCALED_TILE_SIZE) + 4)
+#define DRAW_LIST_CHUNKS_Y (GAME_HEIGHT / (CHUNK_SIZE * SCALED_TILE_SIZE) + 4)
+#define MAX_DRAW_SOURCES (DRAW_LIST_CHUNKS_X * DRAW_LIST_CHUNKS_Y + 1)
+
+// A sorted list being merged into the draw order.
+typedef struct {
+    const draw_entry_t * entries;
+    int count;
+} draw_source_t;
+
+static draw_entry_t DrawEntry(const actor_t * actor)
 {
-    SDL_Rect visible_rect = GetVisibleRect(world->camera);
+    return (draw_entry_t){
+        .handle = actor->handle,
+        .layer = ActorLayer(actor),
+        .y = actor->pos.y
+    };
+}
+
+static bool DrawsBefore(const draw_entry_t * a, const draw_entry_t * b)
+{
+    return a->layer < b->layer || (a->layer == b->layer && a->y < b->y);
+}
+
+// Movers that draw at the same time are ordered by slot, so they don't swap
+// from frame to frame.
+static int CompareMovers(const void * a, const void * b)
+{
+    const draw_entry_t * entry_a = a;
+    const draw_entry_t * entry_b = b;
+
+    if ( DrawsBefore(entry_a, entry_b) ) {
+        return -1;
+    }
+
+    if ( DrawsBefore(entry_b, entry_a) ) {
+        return 1;
+    }
+
+    return entry_a->handle.slot - entry_b->handle.slot;
+}
+
+static array_t * ListOrNew(array_t ** list)
+{
+    if ( *list == NULL ) {
+        *list = NewArray(0, sizeof(draw_entry_t));
+    }
+
+    return *list;
+}
+
+// Props never move, so each stays in the chunk list it was added to.
+static array_t ** PropList(world_t * world, const actor_t * actor)
+{
+    const int chunk_size = CHUNK_SIZE * SCALED_TILE_SIZE;
+
+    int chunk_x = (int)actor->pos.x / chunk_size;
+    int chunk_y = (int)actor->pos.y / chunk_size;
+    CLAMP(chunk_x, 0, WORLD_WIDTH / CHUNK_SIZE - 1);
+    CLAMP(chunk_y, 0, WORLD_HEIGHT / CHUNK_SIZE - 1);
+
+    return &world->draw_list.props[chunk_y][chunk_x];
+}
+
+void AddToDrawList(world_t * world, const actor_t * actor)
+{
+    // Movers are found through the residency buckets when drawing.
+    if ( !ActorIsStatic(actor) ) {
+        return;
+    }
+
+    draw_entry_t entry = DrawEntry(actor);
+
+    // Insert after any props that draw at the same time, like a stable sort.
+    array_t * props = ListOrNew(PropList(world, actor));
+    draw_entry_t * entries = props->data;
+    int low = 0;
+    int high = props->count;
+    while ( low < high ) {
+        int middle = (low + high) / 2;
+        if ( DrawsBefore(&entry, &entries[middle]) ) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    Insert(props, &entry, low);
+}
 
-    // Filter the world actor array: only visible actors
-    actor_t * visible_actors[500] = { 0 }; // TODO: think about size
-    int num_visible = 0;
-    actor_t * actor = world->actors->data;
-    for ( int i = 0; i < world->actors->count; i++, actor++ ) {
+void RemoveFromDrawList(world_t * world, const actor_t * actor)
+{
+    if ( !ActorIsStatic(actor) ) {
+        return;
+    }
+
+    array_t * list = *PropList(world, actor);
+    draw_entry_t * entries = list->data;
+    for ( int i = 0; i < list->count; i++ ) {
+        if ( entries[i].handle.slot == actor->handle.slot ) {
+            Remove(list, i); // Keep the rest in order.
+            return;
+        }
+    }
+
+    Error("%s missing from draw list", ActorName(actor->type));
+}
+
+// Put this frame's visible actors in list->visible, in draw order: merge the
+// movers in nearby chunks, sorted, with the props of nearby chunks. Only
+// actors near the screen are looked at, however many are loaded.
+static void UpdateDrawList(world_t * world, SDL_Rect visible_rect)
+{
+    draw_list_t * list = &world->draw_list;
+    const int chunk_size = CHUNK_SIZE * SCALED_TILE_SIZE;
+
+    ListOrNew(&list->movers);
+    ListOrNew(&list->visible);
+
+    Clear(list->movers);
+    int * residents;
+    int num_residents = GetResidentsNear(world, visible_rect, &residents);
+    for ( int i = 0; i < num_residents; i++ ) {
+        actor_t * actor = GetElement(world->actors, residents[i]);
+        if ( !ActorIsStatic(actor) ) {
+            draw_entry_t entry = DrawEntry(actor);
+            Append(list->movers, &entry);
+        }
+    }
+
+    draw_entry_t * movers = list->movers->data;
+    qsort(movers, list->movers->count, sizeof(*movers), CompareMovers);
+
+    draw_source_t sources[MAX_DRAW_SOURCES];
+    int num_sources = 0;
+    sources[num_sources++] = (draw_source_t){ movers, list->movers->count };
+
+    int min_x = MAX(visible_rect.x / chunk_size - 1, 0);
+    int min_y = MAX(visible_rect.y / chunk_size - 1, 0);
+    int max_x = MIN((visible_rect.x + visible_rect.w) / chunk_size + 1, WORLD_WIDTH / CHUNK_SIZE - 1);
+    int max_y = MIN((visible_rect.y + visible_rect.h) / chunk_size + 1, WORLD_HEIGHT / CHUNK_SIZE - 1);
+    for ( int y = min_y; y <= max_y; y++ ) {
+        for ( int x = min_x; x <= max_x; x++ ) {
+            array_t * props = list->props[y][x];
+            if ( props && props->count && num_sources < MAX_DRAW_SOURCES ) {
+                sources[num_sources++] = (draw_source_t){ props->data, props->count };
+            }
+        }
+    }
+
+    // Merge, keeping only what's on screen.
+    Clear(list->visible);
+    while ( true ) {
+        draw_source_t * next = NULL;
+        for ( int i = 0; i < num_sources; i++ ) {
+            draw_source_t * source = &sources[i];
+            if ( source->count
+                && (next == NULL || DrawsBefore(source->entries, next->entries)) )
+            {
+                next = source;
+            }
+        }
+
+        if ( next == NULL ) {
+            break;
+        }
+
+        const draw_entry_t * entry = next->entries++;
+        next->count--;
+
+        actor_t * actor = GetActor(world, entry->handle);
         if ( GetActorSprite(actor)
             && RectsIntersect(visible_rect, GetActorVisibleRect(actor)) )
         {
-            visible_actors[num_visible++] = actor;
+            Append(list->visible, (void *)entry);
         }
     }
+}
 
-    // Draw collectible items first. TODO: think about a drawing order mechanism.
-    for ( int i = num_visible - 1; i >= 0; i-- ) {
-        if ( visible_actors[i]->flags & ACTOR_FLAG_COLLETIBLE ) {
-            DrawActor(visible_actors[i], visible_rect);
-            visible_actors[i] = visible_actors[--num_visible]; // remove it.
-        }
+void FreeDrawList(world_t * world)
+{
+    draw_list_t * list = &world->draw_list;
+
+    if ( list->movers ) {
+        FreeArray(list->movers);
+    }
+
+    if ( list->visible ) {
+        FreeArray(list->visible);
     }
 
-    // Sort the visible list by y position.
-    for ( int i = 0; i < num_visible; i++ ) {
-        for ( int j = i + 1; j < num_visible; j++ ) {
-            if ( visible_actors[i]->pos.y > visible_actors[j]->pos.y ) {
-                SWAP(visible_actors[i], visible_actors[j]);
+    for ( int y = 0; y < WORLD_HEIGHT / CHUNK_SIZE; y++ ) {
+        for ( int x = 0; x < WORLD_WIDTH / CHUNK_SIZE; x++ ) {
+            if ( list->props[y][x] ) {
+                FreeArray(list->props[y][x]);
             }
         }
     }
 
-    // draw actor shadow
-    for ( int i = 0; i < num_visible; i++ ) {
-        actor_t * actor = visible_actors[i];
+    memset(list, 0, sizeof(*list));
+}
 
-        if ( GetActorSprite(actor) && actor->flags & ACTOR_FLAG_CASTS_SHADOW ) {
+void RenderVisibleActors(world_t * world)
+{
+    SDL_Rect visible_rect = GetVisibleRect(world->camera);
+
+    UpdateDrawList(world, visible_rect);
+    const draw_entry_t * order = world->draw_list.visible->data;
+    int num_visible = world->draw_list.visible->count;
+
+    // The draw order starts with collectible items, which go under
+    // everything. Then shadows, then all other actors.
+    int first_actor = 0;
+    while ( first_actor < num_visible && order[first_actor].layer == LAYER_ITEMS ) {
+        DrawActor(GetActor(world, order[first_actor++].handle), visible_rect);
+    }
+
+    for ( int i = first_actor; i < num_visible; i++ ) {
+        actor_t * actor = GetActor(world, order[i].handle);
+
+        if ( actor->flags & ACTOR_FLAG_CASTS_SHADOW ) {
             SDL_Rect shadow = {
                 .w = (actor->hitbox_width + 4) * DRAW_SCALE,
                 .h = (actor->hitbox_height + 2) * DRAW_SCALE
@@ -370,23 +1216,31 @@ void RenderVisibleActors(world_t * world)
             shadow.x = actor->pos.x - shadow.w / 2 - visible_rect.x;
             shadow.y = actor->pos.y - shadow.h / 2 - visible_rect.y;
 
-            V_SetRGBA(0, 0, 0, 64);
-            V_FillRect(&shadow);
+            QueueRect(&shadow, (SDL_Color){ 0, 0, 0, 64 }, LAYER_SHADOWS, 0);
         }
     }
 
-    // draw actors
-    for ( int i = 0; i < num_visible; i++ ) {
-        DrawActor(visible_actors[i], visible_rect);
+    for ( int i = first_actor; i < num_visible; i++ ) {
+        DrawActor(GetActor(world, order[i].handle), visible_rect);
+    }
+
+    FlushSpritesInOrder();
+
+    if ( show_geometry ) {
+        for ( int i = 0; i < num_visible; i++ ) {
+            DrawActorHitbox(GetActor(world, order[i].handle), visible_rect);
+        }
     }
 }
 
 void RenderWorld(world_t * world)
 {
     int render_start = SDL_GetTicks(); // debug
+    int draw_calls_start = draw_calls; // debug
 
     RenderVisibleTerrain(world);
     RenderVisibleActors(world);
 
     render_ms = SDL_GetTicks() - render_start; // debug
+    render_draw_calls = draw_calls - draw_calls_start; // debug
 }
@@ -7,6 +7,7 @@
 
 #include "w_tile.h"
 #include "w_world.h"
+#include "mylib/video.h"
 
 void RenderGrass(tile_t * tile);
 
@@ -14,17 +15,207 @@ void (* render_functions[NUM_TERRAIN_TYPES])(tile_t *) = {
     [TERRAIN_GRASS] = RenderGrass,
 };
 
-void GetTileNoise(int tile_x, int tile_y, float out[TILE_SIZE][TILE_SIZE])
+#pragma mark - EFFECT NOISE
+
+// Grass effects use the same 6-octave noise as Noise(), at world pixel
+// resolution. It's computed for a whole chunk at a time, into one field that
+// is reused for each chunk as its terrain is drawn.
+//
+// The low octaves change slowly, so they're sampled on a coarse lattice and
+// interpolated. Only the high octaves are evaluated for every pixel. Both are
+// only done for rows of tiles, and tiles, that need them.
+
+#define NOISE_FREQUENCY         0.01f
+#define NOISE_OCTAVES           6
+#define NOISE_COARSE_OCTAVES    4 // 0 to evaluate all octaves per pixel
+#define NOISE_LATTICE_SPACING   4 // pixels
+
+#define CHUNK_PIXELS    (CHUNK_SIZE * TILE_SIZE)
+#define LATTICE_WIDTH   (CHUNK_PIXELS / NOISE_LATTICE_SPACING + 1)
+#define LATTICE_HEIGHT  (TILE_SIZE / NOISE_LATTICE_SPACING + 1)
+#define TILE_LATTICE_WIDTH LATTICE_HEIGHT
+
+static struct {
+    chunk_coord_t chunk;
+    bool has_tile[CHUNK_SIZE][CHUNK_SIZE];
+    float pixels[CHUNK_PIXELS][CHUNK_PIXELS];
+} field;
+
+static bool NeedsEffectNoise(tile_t * tile)
+{
+    return tile->terrain >= TERRAIN_GRASS
+        && tile->terrain <= TERRAIN_DARK_FOREST;
+}
+
+// Low octaves for a row of tiles starting at pixel x, y, every
+// NOISE_LATTICE_SPACING pixels. Scaling the frequency by the spacing puts
+// lattice point (i, j) at pixel (x, y) + (i, j) * spacing.
+static void ComputeLattice
+(   const noise_context_t * noise,
+    float * lattice,
+    int width,
+    int pixel_x,
+    int pixel_y )
 {
-    for ( int y = 0; y < TILE_SIZE; y++ ) {
-        for ( int x = 0; x < TILE_SIZE; x++ ) {
-            int wx = tile_x * TILE_SIZE + x; // world coordinate of tile pixel
-            int wy = tile_y * TILE_SIZE + y;
-            out[y][x] = Noise(wx, wy, 1.0f);
+    if ( NOISE_COARSE_OCTAVES == 0 ) {
+        return;
+    }
+
+    NoiseGrid2
+    (   noise,
+        lattice,
+        width,
+        LATTICE_HEIGHT,
+        pixel_x / NOISE_LATTICE_SPACING,
+        pixel_y / NOISE_LATTICE_SPACING,
+        1.0f / NOISE_LATTICE_SPACING,
+        NOISE_FREQUENCY * NOISE_LATTICE_SPACING,
+        NOISE_COARSE_OCTAVES,
+        1.0f,
+        0.5f,
+        2.0f );
+}
+
+// Add the high octaves for the tile at pixel x, y to its low octaves,
+// interpolated from `lattice`: the tile's top left lattice point, in a lattice
+// with rows `stride` long.
+static void SampleTileNoise
+(   const noise_context_t * noise,
+    const float * lattice,
+    int stride,
+    int pixel_x,
+    int pixel_y,
+    float * out,
+    int out_stride )
+{
+    float fine_frequency = NOISE_FREQUENCY * (1 << NOISE_COARSE_OCTAVES);
+    float fine_amplitude = 1.0f / (1 << NOISE_COARSE_OCTAVES);
+
+    // High octaves, every pixel.
+    float fine[TILE_SIZE][TILE_SIZE];
+    NoiseGrid2
+    (   noise,
+        &fine[0][0],
+        TILE_SIZE,
+        TILE_SIZE,
+        pixel_x,
+        pixel_y,
+        1.0f,
+        fine_frequency,
+        NOISE_OCTAVES - NOISE_COARSE_OCTAVES,
+        fine_amplitude,
+        0.5f,
+        2.0f );
+
+    for ( int py = 0; py < TILE_SIZE; py++ ) {
+        int ly = py / NOISE_LATTICE_SPACING;
+        float fy = (float)(py % NOISE_LATTICE_SPACING) / NOISE_LATTICE_SPACING;
+        const float * row = &lattice[ly * stride];
+
+        for ( int px = 0; px < TILE_SIZE; px++ ) {
+            float coarse = 0.0f;
+
+            if ( NOISE_COARSE_OCTAVES > 0 ) {
+                int lx = px / NOISE_LATTICE_SPACING;
+                float fx = (float)(px % NOISE_LATTICE_SPACING) / NOISE_LATTICE_SPACING;
+                float top = Lerp(row[lx], row[lx + 1], fx);
+                float bottom = Lerp(row[stride + lx], row[stride + lx + 1], fx);
+                coarse = Lerp(top, bottom, fy);
+            }
+
+            out[py * out_stride + px] = coarse + fine[py][px];
         }
     }
 }
 
+void ComputeChunkNoise(world_t * world, chunk_coord_t chunk)
+{
+    tile_coord_t corner = ChunkToTile(chunk);
+    int pixel_x = corner.x * TILE_SIZE;
+    int pixel_y = corner.y * TILE_SIZE;
+
+    field.chunk = chunk;
+    for ( int ty = 0; ty < CHUNK_SIZE; ty++ ) {
+        bool row_needed = false;
+        for ( int tx = 0; tx < CHUNK_SIZE; tx++ ) {
+            tile_t * tile = GetTile(world->tiles, corner.x + tx, corner.y + ty);
+            field.has_tile[ty][tx] = NeedsEffectNoise(tile);
+            row_needed |= field.has_tile[ty][tx];
+        }
+
+        if ( !row_needed ) {
+            continue;
+        }
+
+        float lattice[LATTICE_HEIGHT][LATTICE_WIDTH];
+        ComputeLattice
+        (   &world->effect_noise,
+            &lattice[0][0],
+            LATTICE_WIDTH,
+            pixel_x,
+            pixel_y + ty * TILE_SIZE );
+
+        for ( int tx = 0; tx < CHUNK_SIZE; tx++ ) {
+            if ( !field.has_tile[ty][tx] ) {
+                continue;
+            }
+
+            SampleTileNoise
+            (   &world->effect_noise,
+                &lattice[0][tx * TILE_SIZE / NOISE_LATTICE_SPACING],
+                LATTICE_WIDTH,
+                pixel_x + tx * TILE_SIZE,
+                pixel_y + ty * TILE_SIZE,
+                &field.pixels[ty * TILE_SIZE][tx * TILE_SIZE],
+                CHUNK_PIXELS );
+        }
+    }
+}
+
+void ComputeTileNoise
+(   world_t * world,
+    int tile_x,
+    int tile_y,
+    float out[TILE_SIZE][TILE_SIZE] )
+{
+    float lattice[LATTICE_HEIGHT][TILE_LATTICE_WIDTH];
+    ComputeLattice
+    (   &world->effect_noise,
+        &lattice[0][0],
+        TILE_LATTICE_WIDTH,
+        tile_x * TILE_SIZE,
+        tile_y * TILE_SIZE );
+
+    SampleTileNoise
+    (   &world->effect_noise,
+        &lattice[0][0],
+        TILE_LATTICE_WIDTH,
+        tile_x * TILE_SIZE,
+        tile_y * TILE_SIZE,
+        &out[0][0],
+        TILE_SIZE );
+}
+
+void GetTileNoise(int tile_x, int tile_y, float out[TILE_SIZE][TILE_SIZE])
+{
+    chunk_coord_t chunk = TileToChunk((tile_coord_t){ tile_x, tile_y });
+    int tx = tile_x % CHUNK_SIZE;
+    int ty = tile_y % CHUNK_SIZE;
+
+    if ( chunk.x != field.chunk.x
+        || chunk.y != field.chunk.y
+        || !field.has_tile[ty][tx] )
+    {
+        Error("no effect noise computed for tile %d, %d", tile_x, tile_y);
+    }
+
+    for ( int py = 0; py < TILE_SIZE; py++ ) {
+        memcpy(out[py], &field.pixels[ty * TILE_SIZE + py][tx * TILE_SIZE], sizeof(out[py]));
+    }
+}
+
+#pragma mark -
+
 void RenderGrass(tile_t * tile)
 {
 
@@ -30,11 +30,6 @@ typedef struct tile tile_t;
 struct tile {
     terrain_t terrain;
 
-    // Some tiles have extra, per-tile decoration/
-    // visual effects that are laid over the regular texture
-    // This can be generated dynamically as needed.
-    SDL_Texture * effect;
-
     // A value that can be used to
     // randomize various tile properties.
     u8 variety;
@@ -45,6 +40,4 @@ struct tile {
     void (* render)(tile_t *);
 };
 
-void GetTileNoise(int tile_x, int tile_y, float out[TILE_SIZE][TILE_SIZE]);
-
 #endif /* w_tile_h */
@@ -23,15 +23,691 @@ static void UpdateTiles(world_t * world)
     min.y -= margin;
     max.y += margin;
 
+    bool changed = false;
     for ( int y = min.y; y <= max.y; y++ ) {
         for ( int x = min.x; x <= max.x; x++ ) {
             tile_t * tile = GetTile(world->tiles, x, y);
+            if ( tile == NULL ) {
+                continue; // Off the edge of the world.
+            }
+
+            vec3_t old = tile->lighting;
 
             VectorLerp(&tile->lighting, &world->lighting, 0.1f);
+            changed |= memcmp(&old, &tile->lighting, sizeof(old)) != 0;
+        }
+    }
+
+    // Once every tile has reached the world's lighting, the terrain mesh's
+    // colors stay as they are.
+    if ( changed ) {
+        world->terrain_mesh.unlit = true;
+    }
+}
+
+#pragma mark - CONTACT BROADPHASE
+
+// Hitboxes are binned into grid cells of this size (world pixels), and only
+// actors sharing a cell are tested against each other. A cell holds a few
+// tiles, so most actors are in one to four cells.
+#define CONTACT_CELL_SIZE (SCALED_TILE_SIZE * 2)
+
+bool check_contacts;
+
+// Two actors whose hitboxes overlap, by index, a < b.
+typedef struct {
+    int a;
+    int b;
+} contact_pair_t;
+
+// A hitbox's entry in one of the cells it covers.
+typedef struct {
+    int actor;
+    int cell_x;
+    int cell_y;
+} cell_entry_t;
+
+// Scratch space, grown as needed.
+static cell_entry_t * cell_entries;
+static cell_entry_t * sorted_entries;
+static int entries_capacity;
+static int * bucket_starts;
+static int buckets_capacity;
+static contact_pair_t * pairs;
+static int pairs_capacity;
+
+static void AddPair(int * num_pairs, int a, int b)
+{
+    if ( *num_pairs == pairs_capacity ) {
+        pairs_capacity = pairs_capacity ? pairs_capacity * 2 : 64;
+        pairs = realloc(pairs, pairs_capacity * sizeof(*pairs));
+        if ( pairs == NULL ) {
+            Error("could not grow contact pairs");
+        }
+    }
+
+    pairs[(*num_pairs)++] = (contact_pair_t){ a, b };
+}
+
+static int ComparePairs(const void * p1, const void * p2)
+{
+    const contact_pair_t * a = p1;
+    const contact_pair_t * b = p2;
+
+    if ( a->a != b->a ) {
+        return a->a - b->a;
+    }
+
+    return a->b - b->b;
+}
+
+static int CellOf(float coord)
+{
+    return (int)floorf(coord / CONTACT_CELL_SIZE);
+}
+
+static unsigned CellHash(int cell_x, int cell_y)
+{
+    return (unsigned)cell_x * 73856093u ^ (unsigned)cell_y * 19349663u;
+}
+
+// Test every pair. For checking FindContacts.
+static int FindContactsBruteForce(const SDL_FRect * hitboxes, int count)
+{
+    int num_pairs = 0;
+
+    for ( int i = 0; i < count; i++ ) {
+        for ( int j = i + 1; j < count; j++ ) {
+            if ( SDL_HasIntersectionF(&hitboxes[i], &hitboxes[j]) ) {
+                AddPair(&num_pairs, i, j);
+            }
+        }
+    }
+
+    return num_pairs;
+}
+
+// Find every pair of overlapping hitboxes. Pairs are left in `pairs`, in the
+// same order as FindContactsBruteForce.
+static int FindContacts(const SDL_FRect * hitboxes, int count)
+{
+    // Bin each hitbox into the cells it covers.
+    int num_entries = 0;
+    for ( int pass = 0; pass < 2; pass++ ) {
+        for ( int i = 0; i < count; i++ ) {
+            const SDL_FRect * box = &hitboxes[i];
+            if ( box->w <= 0.0f || box->h <= 0.0f ) {
+                continue; // Empty boxes don't intersect anything.
+            }
+
+            int min_x = CellOf(box->x);
+            int min_y = CellOf(box->y);
+            int max_x = CellOf(box->x + box->w);
+            int max_y = CellOf(box->y + box->h);
+
+            for ( int y = min_y; y <= max_y; y++ ) {
+                for ( int x = min_x; x <= max_x; x++ ) {
+                    if ( pass == 1 ) {
+                        cell_entries[num_entries] = (cell_entry_t){ i, x, y };
+                    }
+                    num_entries++;
+                }
+            }
+        }
+
+        // First pass only counts.
+        if ( pass == 0 ) {
+            if ( num_entries > entries_capacity ) {
+                entries_capacity = num_entries * 2;
+                cell_entries = realloc(cell_entries, entries_capacity * sizeof(*cell_entries));
+                sorted_entries = realloc(sorted_entries, entries_capacity * sizeof(*sorted_entries));
+                if ( cell_entries == NULL || sorted_entries == NULL ) {
+                    Error("could not grow contact grid");
+                }
+            }
+            num_entries = 0;
+        }
+    }
+
+    // Group entries by cell hash with a counting sort. Different cells can
+    // share a bucket, so entries are still checked for the same cell below.
+    int num_buckets = 1;
+    while ( num_buckets < num_entries * 2 ) {
+        num_buckets *= 2;
+    }
+
+    if ( num_buckets + 1 > buckets_capacity ) {
+        buckets_capacity = num_buckets + 1;
+        bucket_starts = realloc(bucket_starts, buckets_capacity * sizeof(*bucket_starts));
+        if ( bucket_starts == NULL ) {
+            Error("could not grow contact grid");
+        }
+    }
+
+    memset(bucket_starts, 0, (num_buckets + 1) * sizeof(*bucket_starts));
+    for ( int i = 0; i < num_entries; i++ ) {
+        unsigned bucket = CellHash(cell_entries[i].cell_x, cell_entries[i].cell_y) & (num_buckets - 1);
+        bucket_starts[bucket + 1]++;
+    }
+
+    for ( int i = 0; i < num_buckets; i++ ) {
+        bucket_starts[i + 1] += bucket_starts[i];
+    }
+
+    // Fill using bucket_starts as write cursors, which shifts each one to the
+    // next bucket's start. Shift back after.
+    for ( int i = 0; i < num_entries; i++ ) {
+        unsigned bucket = CellHash(cell_entries[i].cell_x, cell_entries[i].cell_y) & (num_buckets - 1);
+        sorted_entries[bucket_starts[bucket]++] = cell_entries[i];
+    }
+
+    for ( int i = num_buckets; i > 0; i-- ) {
+        bucket_starts[i] = bucket_starts[i - 1];
+    }
+    bucket_starts[0] = 0;
+
+    // Test pairs within each cell. A pair that shares several cells is only
+    // reported by the one containing the top left of their overlap.
+    int num_pairs = 0;
+    for ( int bucket = 0; bucket < num_buckets; bucket++ ) {
+        for ( int i = bucket_starts[bucket]; i < bucket_starts[bucket + 1]; i++ ) {
+            const cell_entry_t * e1 = &sorted_entries[i];
+
+            for ( int j = i + 1; j < bucket_starts[bucket + 1]; j++ ) {
+                const cell_entry_t * e2 = &sorted_entries[j];
+                if ( e1->cell_x != e2->cell_x || e1->cell_y != e2->cell_y ) {
+                    continue;
+                }
+
+                const SDL_FRect * a = &hitboxes[e1->actor];
+                const SDL_FRect * b = &hitboxes[e2->actor];
+                if ( !SDL_HasIntersectionF(a, b) ) {
+                    continue;
+                }
+
+                if ( CellOf(MAX(a->x, b->x)) != e1->cell_x
+                    || CellOf(MAX(a->y, b->y)) != e1->cell_y )
+                {
+                    continue;
+                }
+
+                AddPair(&num_pairs, MIN(e1->actor, e2->actor), MAX(e1->actor, e2->actor));
+            }
+        }
+    }
+
+    // Contact functions can have side effects, so keep the order they were
+    // called in before.
+    qsort(pairs, num_pairs, sizeof(*pairs), ComparePairs);
+
+    return num_pairs;
+}
+
+// Check FindContacts against testing every pair. Returns the number of
+// pairs that differ. `pairs` is left as FindContacts found them.
+static int CheckContacts(const SDL_FRect * hitboxes, int count, int num_pairs)
+{
+    size_t size = num_pairs * sizeof(*pairs);
+    contact_pair_t * found = malloc(size + 1); // Not NULL when there are none.
+    if ( found == NULL ) {
+        Error("could not allocate contact check");
+    }
+    memcpy(found, pairs, size);
+
+    int num_expected = FindContactsBruteForce(hitboxes, count);
+    int errors = abs(num_expected - num_pairs);
+    for ( int i = 0; i < MIN(num_pairs, num_expected); i++ ) {
+        if ( found[i].a != pairs[i].a || found[i].b != pairs[i].b ) {
+            errors++;
+        }
+    }
+
+    memcpy(pairs, found, size); // Capacity only grows, so this fits.
+    free(found);
+
+    return errors;
+}
+
+void ContactBenchmark(void)
+{
+    const int counts[] = { 1000, 5000, 20000 };
+
+    for ( int c = 0; c < 3; c++ ) {
+        int count = counts[c];
+        SDL_FRect * hitboxes = malloc(count * sizeof(*hitboxes));
+        if ( hitboxes == NULL ) {
+            Error("could not allocate benchmark hitboxes");
+        }
+
+        // About one actor per tile, like a dense forest, with hitboxes
+        // from tree sized to hand strike sized.
+        float side = sqrtf(count) * SCALED_TILE_SIZE;
+        for ( int i = 0; i < count; i++ ) {
+            float size = RandomFloat(4.0f, TILE_SIZE) * DRAW_SCALE;
+            hitboxes[i] = (SDL_FRect){
+                RandomFloat(0.0f, side),
+                RandomFloat(0.0f, side),
+                size,
+                size
+            };
+        }
+
+        float start = ProgramTime();
+        int num_pairs = FindContacts(hitboxes, count);
+        float grid_time = ProgramTime() - start;
+
+        start = ProgramTime();
+        int errors = CheckContacts(hitboxes, count, num_pairs);
+        float brute_time = ProgramTime() - start;
+
+        printf("contacts, %5d actors: %6d pairs, grid %7.3f ms, "
+               "brute force %8.3f ms, %d differ\n",
+               count,
+               num_pairs,
+               grid_time * 1000.0f,
+               brute_time * 1000.0f,
+               errors);
+
+        free(hitboxes);
+    }
+}
+
+#pragma mark - STATIC COLLISION INDEX
+
+// Candidates for one collision check: indices into world->actors.
+static int * candidates;
+static int candidates_capacity;
+
+static void AddCandidate(int * count, int index)
+{
+    if ( *count == candidates_capacity ) {
+        candidates_capacity = candidates_capacity ? candidates_capacity * 2 : 64;
+        candidates = realloc(candidates, candidates_capacity * sizeof(*candidates));
+        if ( candidates == NULL ) {
+            Error("could not grow collision candidates");
+        }
+    }
+
+    candidates[(*count)++] = index;
+}
+
+static int CompareInts(const void * a, const void * b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static bool IsStaticSolid(const actor_t * actor)
+{
+    return actor->flags & ACTOR_FLAG_SOLID && ActorIsStatic(actor);
+}
+
+// The world tiles a box covers, clamped to the world.
+static void BoxTileRange(SDL_FRect box, SDL_Point * min, SDL_Point * max)
+{
+    min->x = (int)floorf(box.x / SCALED_TILE_SIZE);
+    min->y = (int)floorf(box.y / SCALED_TILE_SIZE);
+    max->x = (int)floorf((box.x + box.w) / SCALED_TILE_SIZE);
+    max->y = (int)floorf((box.y + box.h) / SCALED_TILE_SIZE);
+    CLAMP(min->x, 0, WORLD_WIDTH - 1);
+    CLAMP(min->y, 0, WORLD_HEIGHT - 1);
+    CLAMP(max->x, 0, WORLD_WIDTH - 1);
+    CLAMP(max->y, 0, WORLD_HEIGHT - 1);
+}
+
+static int CellInChunk(int tile_x, int tile_y)
+{
+    return (tile_y % CHUNK_SIZE) * CHUNK_SIZE + tile_x % CHUNK_SIZE;
+}
+
+// Put the static solid at `index` in every tile its hitbox covers.
+static void AddStaticSolid(world_t * world, int index)
+{
+    collision_index_t * collision_index = &world->collision_index;
+
+    SDL_Point min, max;
+    BoxTileRange(ActorHitbox(GetElement(world->actors, index)), &min, &max);
+
+    for ( int y = min.y; y <= max.y; y++ ) {
+        for ( int x = min.x; x <= max.x; x++ ) {
+            solid_cell_list_t ** list = &collision_index->chunks[y / CHUNK_SIZE][x / CHUNK_SIZE];
+            if ( *list == NULL ) {
+                *list = malloc(sizeof(**list));
+                if ( *list == NULL ) {
+                    Error("could not allocate collision index");
+                }
+
+                for ( int c = 0; c < CHUNK_SIZE * CHUNK_SIZE; c++ ) {
+                    (*list)->cells[c] = -1;
+                }
+                (*list)->entries = NewArray(0, sizeof(solid_entry_t));
+                (*list)->free_entry = -1;
+            }
+
+            int cell = CellInChunk(x, y);
+            solid_entry_t new_entry = { index, (*list)->cells[cell] };
+            int entry_index = (*list)->free_entry;
+
+            if ( entry_index != -1 ) {
+                solid_entry_t * entry = GetElement((*list)->entries, entry_index);
+                (*list)->free_entry = entry->next;
+                *entry = new_entry;
+            } else {
+                Append((*list)->entries, &new_entry);
+                entry_index = (*list)->entries->count - 1;
+            }
+
+            (*list)->cells[cell] = entry_index;
+        }
+    }
+}
+
+// Point the static solid at `index`'s entries at `new_index` instead, or
+// unlink them if `new_index` is -1.
+static void MoveStaticSolid(world_t * world, int index, int new_index)
+{
+    collision_index_t * collision_index = &world->collision_index;
+
+    SDL_Point min, max;
+    BoxTileRange(ActorHitbox(GetElement(world->actors, index)), &min, &max);
+
+    for ( int y = min.y; y <= max.y; y++ ) {
+        for ( int x = min.x; x <= max.x; x++ ) {
+            solid_cell_list_t * list = collision_index->chunks[y / CHUNK_SIZE][x / CHUNK_SIZE];
+            solid_entry_t * entries = list->entries->data;
+            int * link = &list->cells[CellInChunk(x, y)];
+
+            while ( *link != -1 && entries[*link].actor != index ) {
+                link = &entries[*link].next;
+            }
+
+            if ( *link == -1 ) {
+                Error("static solid %d missing from collision index", index);
+            }
+
+            if ( new_index != -1 ) {
+                entries[*link].actor = new_index;
+            } else {
+                int entry_index = *link;
+                *link = entries[entry_index].next;
+                entries[entry_index].next = list->free_entry;
+                list->free_entry = entry_index;
+            }
+        }
+    }
+}
+
+// Get the solids `box` might hit: static solids in the tiles it covers, and
+// all of `dynamic_blocks`. Returns the count; they're put in `out` in
+// actor array order, as DoCollisions expects.
+static int GetNearbySolids
+(   world_t * world,
+    SDL_FRect box,
+    actor_t ** dynamic_blocks,
+    int num_dynamic_blocks,
+    actor_t *** out )
+{
+    static actor_t ** solids;
+    static int solids_capacity;
+
+    collision_index_t * index = &world->collision_index;
+    actor_t * actors = world->actors->data;
+    int count = 0;
+
+    SDL_Point min, max;
+    BoxTileRange(box, &min, &max);
+
+    for ( int y = min.y; y <= max.y; y++ ) {
+        for ( int x = min.x; x <= max.x; x++ ) {
+            solid_cell_list_t * list = index->chunks[y / CHUNK_SIZE][x / CHUNK_SIZE];
+            if ( list == NULL ) {
+                continue;
+            }
+
+            solid_entry_t * entries = list->entries->data;
+            int cell = CellInChunk(x, y);
+            for ( int i = list->cells[cell]; i != -1; i = entries[i].next ) {
+                AddCandidate(&count, entries[i].actor);
+            }
+        }
+    }
+
+    for ( int i = 0; i < num_dynamic_blocks; i++ ) {
+        AddCandidate(&count, (int)(dynamic_blocks[i] - actors));
+    }
+
+    // A solid covering several tiles was found more than once.
+    qsort(candidates, count, sizeof(*candidates), CompareInts);
+
+    if ( count > solids_capacity ) {
+        solids_capacity = candidates_capacity;
+        solids = realloc(solids, solids_capacity * sizeof(*solids));
+        if ( solids == NULL ) {
+            Error("could not grow collision candidates");
+        }
+    }
+
+    int num_solids = 0;
+    for ( int i = 0; i < count; i++ ) {
+        if ( i == 0 || candidates[i] != candidates[i - 1] ) {
+            solids[num_solids++] = &actors[candidates[i]];
+        }
+    }
+
+    *out = solids;
+    return num_solids;
+}
+
+// Move an actor along one axis and clip it against solids in the way.
+static void MoveActor
+(   world_t * world,
+    actor_t * actor,
+    bool vertical,
+    float distance,
+    actor_t ** dynamic_blocks,
+    int num_dynamic_blocks )
+{
+    SDL_FRect swept = ActorHitbox(actor);
+
+    if ( vertical ) {
+        actor->pos.y += distance;
+        swept.h += fabsf(distance);
+        swept.y += MIN(distance, 0.0f);
+    } else {
+        actor->pos.x += distance;
+        swept.w += fabsf(distance);
+        swept.x += MIN(distance, 0.0f);
+    }
+
+    if ( actor->flags & ACTOR_FLAG_NONINTERACTIVE ) {
+        return;
+    }
+
+    actor_t ** solids;
+    int num_solids = GetNearbySolids
+    (   world,
+        swept,
+        dynamic_blocks,
+        num_dynamic_blocks,
+        &solids );
+
+    DoCollisions(vertical, actor, solids, num_solids);
+}
+
+void FreeCollisionIndex(world_t * world)
+{
+    collision_index_t * index = &world->collision_index;
+
+    for ( int y = 0; y < WORLD_HEIGHT / CHUNK_SIZE; y++ ) {
+        for ( int x = 0; x < WORLD_WIDTH / CHUNK_SIZE; x++ ) {
+            if ( index->chunks[y][x] ) {
+                FreeArray(index->chunks[y][x]->entries);
+                free(index->chunks[y][x]);
+                index->chunks[y][x] = NULL;
+            }
+        }
+    }
+}
+
+#pragma mark - ACTOR RESIDENCY
+
+// Farther than any actor's sprite reaches from its position. Buckets this
+// far outside the active rect are searched too.
+#define RESIDENCY_MARGIN (4 * SCALED_TILE_SIZE)
+
+static chunk_coord_t ActorChunk(const actor_t * actor)
+{
+    const int chunk_size = CHUNK_SIZE * SCALED_TILE_SIZE;
+    int x = (int)floorf(actor->pos.x / chunk_size);
+    int y = (int)floorf(actor->pos.y / chunk_size);
+    CLAMP(x, 0, WORLD_WIDTH / CHUNK_SIZE - 1);
+    CLAMP(y, 0, WORLD_HEIGHT / CHUNK_SIZE - 1);
+
+    return (chunk_coord_t){ x, y };
+}
+
+static void AddResident(world_t * world, int index)
+{
+    actor_t * actor = GetElement(world->actors, index);
+    actor->bucket = ActorChunk(actor);
+
+    array_t ** bucket = &world->residency.chunks[actor->bucket.y][actor->bucket.x];
+    if ( *bucket == NULL ) {
+        *bucket = NewArray(0, sizeof(int));
+    }
+    Append(*bucket, &index);
+}
+
+// Change `index`'s entry in its bucket to `new_index`, or remove it if
+// `new_index` is -1.
+static void MoveResident(world_t * world, int index, int new_index)
+{
+    actor_t * actor = GetElement(world->actors, index);
+    array_t * bucket = world->residency.chunks[actor->bucket.y][actor->bucket.x];
+    int * indices = bucket->data;
+
+    for ( int i = 0; i < bucket->count; i++ ) {
+        if ( indices[i] == index ) {
+            if ( new_index != -1 ) {
+                indices[i] = new_index;
+            } else {
+                FastRemove(bucket, i);
+            }
+            return;
+        }
+    }
+
+    Error("actor %d missing from its chunk bucket", index);
+}
+
+int GetResidentsNear(world_t * world, SDL_Rect rect, int ** out)
+{
+    static int * residents;
+    static int residents_capacity;
+
+    actor_residency_t * residency = &world->residency;
+    const int chunk_size = CHUNK_SIZE * SCALED_TILE_SIZE;
+
+    int min_x = (rect.x - RESIDENCY_MARGIN) / chunk_size;
+    int min_y = (rect.y - RESIDENCY_MARGIN) / chunk_size;
+    int max_x = (rect.x + rect.w + RESIDENCY_MARGIN) / chunk_size;
+    int max_y = (rect.y + rect.h + RESIDENCY_MARGIN) / chunk_size;
+    CLAMP(min_x, 0, WORLD_WIDTH / CHUNK_SIZE - 1);
+    CLAMP(min_y, 0, WORLD_HEIGHT / CHUNK_SIZE - 1);
+    CLAMP(max_x, 0, WORLD_WIDTH / CHUNK_SIZE - 1);
+    CLAMP(max_y, 0, WORLD_HEIGHT / CHUNK_SIZE - 1);
+
+    int count = 0;
+    for ( int y = min_y; y <= max_y; y++ ) {
+        for ( int x = min_x; x <= max_x; x++ ) {
+            array_t * bucket = residency->chunks[y][x];
+            if ( bucket == NULL ) {
+                continue;
+            }
+
+            if ( count + bucket->count > residents_capacity ) {
+                residents_capacity = (count + bucket->count) * 2;
+                residents = realloc(residents, residents_capacity * sizeof(*residents));
+                if ( residents == NULL ) {
+                    Error("could not grow resident list");
+                }
+            }
+
+            memcpy(&residents[count], bucket->data, bucket->count * sizeof(int));
+            count += bucket->count;
+        }
+    }
+
+    // Actors are processed in array order, as if they'd all been looked at.
+    qsort(residents, count, sizeof(*residents), CompareInts);
+
+    *out = residents;
+    return count;
+}
+
+// Move actors that crossed into another chunk to that chunk's bucket.
+static void UpdateResidency(world_t * world, actor_t ** actors, int count)
+{
+    for ( int i = 0; i < count; i++ ) {
+        chunk_coord_t chunk = ActorChunk(actors[i]);
+
+        if ( chunk.x != actors[i]->bucket.x || chunk.y != actors[i]->bucket.y ) {
+            int index = (int)(actors[i] - (actor_t *)world->actors->data);
+            MoveResident(world, index, -1);
+            AddResident(world, index);
         }
     }
 }
 
+void FreeActorResidency(world_t * world)
+{
+    actor_residency_t * residency = &world->residency;
+
+    for ( int y = 0; y < WORLD_HEIGHT / CHUNK_SIZE; y++ ) {
+        for ( int x = 0; x < WORLD_WIDTH / CHUNK_SIZE; x++ ) {
+            if ( residency->chunks[y][x] ) {
+                FreeArray(residency->chunks[y][x]);
+                residency->chunks[y][x] = NULL;
+            }
+        }
+    }
+}
+
+#pragma mark - ACTOR INDEXES
+
+// Appending doesn't move anyone else, so new actors are just added.
+void ActorsAppended(world_t * world, int count)
+{
+    for ( int i = world->actors->count - count; i < world->actors->count; i++ ) {
+        AddResident(world, i);
+        AddToDrawList(world, GetElement(world->actors, i));
+
+        if ( IsStaticSolid(GetElement(world->actors, i)) ) {
+            AddStaticSolid(world, i);
+        }
+    }
+}
+
+void ActorRemoving(world_t * world, int index)
+{
+    int last = world->actors->count - 1;
+
+    MoveResident(world, index, -1);
+    RemoveFromDrawList(world, GetElement(world->actors, index));
+    if ( IsStaticSolid(GetElement(world->actors, index)) ) {
+        MoveStaticSolid(world, index, -1);
+    }
+
+    // The last actor is about to be moved into index's place.
+    if ( last != index ) {
+        MoveResident(world, last, index);
+        if ( IsStaticSolid(GetElement(world->actors, last)) ) {
+            MoveStaticSolid(world, last, index);
+        }
+    }
+}
+
+#pragma mark -
+
 static void UpdateActors
 (   world_t * world,
     const control_state_t * control_state,
@@ -53,14 +729,17 @@ static void UpdateActors
     active_rect.y -= tile_margin * TILE_SIZE;
 
     // Add all actors within the active rect, they will be processed.
-    // Add solid actors to a separate list of blocks.
-    for ( int i = 0; i < world->actors->count; i++ ) {
-        actor_t * actor = GetElement(world->actors, i);
+    // Add solid actors that can move to a separate list of blocks. Those
+    // that can't are found with the collision index.
+    int * residents;
+    int num_residents = GetResidentsNear(world, active_rect, &residents);
+    for ( int i = 0; i < num_residents; i++ ) {
+        actor_t * actor = GetElement(world->actors, residents[i]);
 
         if ( RectsIntersect(GetActorVisibleRect(actor), active_rect) ) {
             if ( num_active < max_active ) {
                 active_actors[num_active++] = actor;
-                if ( actor->flags & ACTOR_FLAG_SOLID ) {
+                if ( actor->flags & ACTOR_FLAG_SOLID && !ActorIsStatic(actor) ) {
                     blocks[num_blocks++] = actor;
                 }
             }
@@ -90,67 +769,71 @@ static void UpdateActors
 
         // horizontal movement:
         if ( actor->vel.x ) {
-            actor->pos.x += actor->vel.x * dt;
-            if ( !(actor->flags & ACTOR_FLAG_NONINTERACTIVE) ) {
-                DoCollisions(false, actor, blocks, num_blocks);
-            }
+            MoveActor(world, actor, false, actor->vel.x * dt, blocks, num_blocks);
         }
 
         // vertical movement:
         if ( actor->vel.y ) {
-            actor->pos.y += actor->vel.y * dt;
-            if ( !(actor->flags & ACTOR_FLAG_NONINTERACTIVE) ) {
-                DoCollisions(true, actor, blocks, num_blocks);
-            }
+            MoveActor(world, actor, true, actor->vel.y * dt, blocks, num_blocks);
         }
 
         UpdateActor(actor, dt);
     }
 
     // Handle any collisions with interactable objects (non-solid things).
+    SDL_FRect hitboxes[max_active];
     for ( int i = 0; i < num_active; i++ ) {
-        actor_t * ai = active_actors[i];
-
-        SDL_FRect hitbox_i = ActorHitbox(ai);
+        hitboxes[i] = ActorHitbox(active_actors[i]);
+    }
 
-        for ( int j = i + 1; j < num_active; j++ ) {
-            actor_t * aj = active_actors[j];
+    int num_pairs = FindContacts(hitboxes, num_active);
+    if ( check_contacts ) {
+        int errors = CheckContacts(hitboxes, num_active, num_pairs);
+        if ( errors ) {
+            printf("contact grid: %d pairs differ from brute force!\n", errors);
+        }
+    }
 
-            SDL_FRect hitbox_j = ActorHitbox(aj);
-            if ( SDL_HasIntersectionF(&hitbox_i, &hitbox_j) ) {
+    for ( int i = 0; i < num_pairs; i++ ) {
+        actor_t * ai = active_actors[pairs[i].a];
+        actor_t * aj = active_actors[pairs[i].b];
 
-                //printf("%s hit an %s\n", ActorName(ai->type), ActorName(aj->type));
+        //printf("%s hit an %s\n", ActorName(ai->type), ActorName(aj->type));
 
-                // contact each other
-                if ( ai->contact ) {
-                    ai->contact(ai, aj);
-                } else if ( ai->state && ai->state->contact ) {
-                    ai->state->contact(ai, aj);
-                }
+        // contact each other
+        if ( ai->contact ) {
+            ai->contact(ai, aj);
+        } else if ( ai->state && ai->state->contact ) {
+            ai->state->contact(ai, aj);
+        }
 
-                if ( aj->contact ) {
-                    aj->contact(aj, ai);
-                } else if ( aj->state && aj->state->contact ) {
-                    aj->state->contact(aj, ai);
-                }
-            }
+        if ( aj->contact ) {
+            aj->contact(aj, ai);
+        } else if ( aj->state && aj->state->contact ) {
+            aj->state->contact(aj, ai);
         }
     }
 
     world->updating_actors = false;
 
-    // Remove any actors that were flagged for removal.
-    for ( int i = world->actors->count - 1; i >= 0; i-- ) {
-        actor_t * actor = GetElement(world->actors, i);
-        if ( actor->flags & ACTOR_FLAG_REMOVE ) {
-            Remove(world->actors, i);
+    UpdateResidency(world, active_actors, num_active);
+
+    // Remove any actors that were flagged for removal. Only updates and
+    // contacts flag actors, and actors spawned flagged (hand strikes) are
+    // next to the player, so only active actors need checking. Going
+    // backwards, the actor moved into a removed one's place has a higher
+    // index, so it's already been checked.
+    actor_t * actors = world->actors->data;
+    for ( int i = num_active - 1; i >= 0; i-- ) {
+        if ( active_actors[i]->flags & ACTOR_FLAG_REMOVE ) {
+            RemoveActor(world, (int)(active_actors[i] - actors));
         }
     }
 
     // Move all pending actors to main array.
-    for ( int i = world->pending_actors->count - 1; i >= 0; i-- ) {
-        Append(world->actors, GetElement(world->pending_actors, i));
-        Remove(world->pending_actors, i);
+    if ( world->pending_actors->count ) {
+        AddActors(world, world->pending_actors->data, world->pending_actors->count);
+        Clear(world->pending_actors);
     }
 }
 
@@ -191,15 +874,18 @@ void UpdateWorld
         world->lighting.z = 255;
     }
 
-    // load chunks around the player
-    actor_t * player = GetActorType(world->actors, ACTOR_PLAYER);
+    // Add any chunks generated since last frame, then queue chunks
+    // around the player.
+    CommitGeneratedChunks(world);
+    actor_t * player = GetActor(world, world->player);
     LoadChunkInRegion(world, player->pos, CHUNK_LOAD_RADIUS_TILES);
+    PrefetchChunks(world, player->vel);
 
     UpdateTiles(world); // lighting
     UpdateActors(world, control_state, dt);
 
     // Update camera
-    PlayerUpdateCamera(GetActorType(world->actors, ACTOR_PLAYER), dt);
+    PlayerUpdateCamera(GetActor(world, world->player), dt);
 
     update_ms = SDL_GetTicks() - update_start; // debug
 }
@@ -21,6 +21,11 @@
 #define CHUNK_SIZE 16
 #define CHUNK_LOAD_RADIUS_TILES 24
 
+// Unloaded chunks within this radius of the camera target are generated
+// ahead of time, soonest-visible first, at most CHUNK_PREFETCH_BUDGET per frame.
+#define CHUNK_PREFETCH_RADIUS_TILES 48
+#define CHUNK_PREFETCH_BUDGET 2
+
 #define DAY_LENGTH_TICKS    (int)(1200000.0f / (1000.0f / FPS))
 #define HOUR_TICKS          (DAY_LENGTH_TICKS / 24)
 #define MORNING_START_TICKS (HOUR_TICKS * 6)
@@ -31,16 +36,171 @@
 
 #define PENDING_ACTORS_MAX 200
 
+// Land tiles joined into islands by a union-find (see w_island.c). Indexed
+// like world tiles.
+typedef struct {
+    int parent[WORLD_WIDTH * WORLD_HEIGHT]; // -1 if not land or not loaded
+    int area[WORLD_WIDTH * WORLD_HEIGHT];   // Tiles in island, at roots only.
+} island_map_t;
+
+// Sides of a grass tile that border water, and get a highlight.
+typedef enum {
+    EFFECT_EDGE_NORTH   = 0x01,
+    EFFECT_EDGE_WEST    = 0x02,
+    EFFECT_EDGE_EAST    = 0x04,
+    NUM_EFFECT_EDGE_MASKS = 8,
+} effect_edge_t;
+
+// Variants per edge mask when grass effects are drawn from a pool.
+#define NUM_EFFECT_VARIANTS 32
+
+// Grass effects rasterized for grass_effect_variants (see w_render.c).
+typedef struct effect_variants effect_variants_t;
+
+// Chunk terrain kept for drawing, in slots of texture pages (see
+// w_render.c).
+#define TERRAIN_PAGE_COLUMNS 4
+#define TERRAIN_PAGE_SLOTS (TERRAIN_PAGE_COLUMNS * TERRAIN_PAGE_COLUMNS)
+#define MAX_TERRAIN_PAGES 16
+#define MAX_TERRAIN_SLOTS (MAX_TERRAIN_PAGES * TERRAIN_PAGE_SLOTS)
+
+// Default for terrain_cache_budget: four terrain pages, 64 chunks.
+#define TERRAIN_CACHE_DEFAULT_BUDGET (16 * 1024 * 1024)
+
+typedef struct {
+    chunk_coord_t chunk;
+    int last_drawn;
+    bool dirty; // Chunk's tiles have changed since it was drawn.
+} terrain_slot_t;
+
+typedef struct {
+    int hits; // Visible chunks drawn as they were cached.
+    int misses; // Visible chunks that had to be baked, new or changed.
+    int evictions;
+    size_t resident_bytes; // Texture memory in terrain pages.
+} terrain_cache_stats_t;
+
+// Most tiles that can be partly on screen at once.
+#define MAX_VISIBLE_TILES \
+    ((GAME_WIDTH / SCALED_TILE_SIZE + 2) * (GAME_HEIGHT / SCALED_TILE_SIZE + 2))
+
+// The visible terrain as tile quads textured from the terrain pages.
+typedef struct {
+    SDL_Vertex vertices[MAX_VISIBLE_TILES * 4];
+    int num_tiles;
+    int indices[MAX_VISIBLE_TILES * 6]; // Quads grouped by page.
+    int page_tiles[MAX_TERRAIN_PAGES]; // Number of quads from each page.
+    SDL_Point min; // Tile range the mesh was built for.
+    SDL_Point max;
+    SDL_Point origin; // Visible rect position the vertices are placed for.
+    bool dirty; // Needs to be rebuilt, e.g. after terrain slots changed.
+    bool unlit; // Vertex colors need updating: tile lighting has changed.
+} terrain_mesh_t;
+
+// An actor in a draw list, with its sort key.
+typedef struct {
+    actor_handle_t handle;
+    u8 layer; // See ActorLayer().
+    float y;
+} draw_entry_t;
+
+// Actors to draw (see w_render.c). Lists are of draw_entry_t. Props are
+// added and removed as they're added to and removed from the world, and
+// kept sorted. Movers are gathered from nearby chunks each frame.
+typedef struct {
+    // Actors that can move and might be visible this frame.
+    array_t * movers;
+
+    // Actors that can't (trees, items), by chunk, sorted.
+    array_t * props[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+
+    array_t * visible; // This frame's draw order.
+} draw_list_t;
+
+// A static solid in one tile of a solid_cell_list_t.
+typedef struct {
+    int actor; // Index into world->actors.
+    int next; // The next entry in the same tile or in the free list, or -1.
+} solid_entry_t;
+
+// A chunk's static solid actors, by the tiles their hitboxes cover.
+typedef struct {
+    int cells[CHUNK_SIZE * CHUNK_SIZE]; // First entry in each tile, or -1.
+    array_t * entries; // solid_entry_t
+    int free_entry; // First unused entry, or -1.
+} solid_cell_list_t;
+
+// Where static solids (trees, bushes) are, so moving actors only check the
+// ones nearby (see w_update.c). Kept up to date as actors are added and
+// removed.
+typedef struct {
+    solid_cell_list_t * chunks[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+} collision_index_t;
+
+// Actors by the chunk their position is in, so finding those near the
+// camera doesn't mean looking at all of them (see w_update.c).
+typedef struct {
+    array_t * chunks[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+} actor_residency_t;
+
+// An entry in world->actor_slots.
+typedef struct {
+    // The actor's index in world->actors. If the slot is free, the next
+    // free slot instead, or -1.
+    int index;
+    int generation; // Incremented when the slot is freed.
+} actor_slot_t;
+
 typedef struct world {
     bool loaded_chunks[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+
+    // Chunks queued for or being generated by a worker thread. A chunk is
+    // never both generating and loaded.
+    bool generating_chunks[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+
+    // Chunks that have been on screen, for prefetch hit/miss stats.
+    bool seen_chunks[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+
     tile_t tiles[WORLD_WIDTH * WORLD_HEIGHT];
 
+    island_map_t islands;
+
+    SDL_Texture * terrain_pages[MAX_TERRAIN_PAGES];
+    terrain_slot_t terrain_cache[MAX_TERRAIN_SLOTS];
+    // Each chunk's slot in terrain_cache, or -1.
+    int terrain_slots[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+    int free_terrain_slots[MAX_TERRAIN_SLOTS]; // A stack.
+    int num_free_terrain_slots;
+    int terrain_capacity; // Slots allowed by terrain_cache_budget.
+    terrain_cache_stats_t terrain_stats;
+    effect_variants_t * effect_variants; // NULL until first needed.
+    terrain_mesh_t terrain_mesh;
+
+    // Keys the per-chunk RNG streams used during generation.
+    u32 seed;
+
+    // Terrain noise. Seeded when the world is created and read-only after
+    // that, so chunk workers can share it.
+    noise_context_t terrain_noise;
+
+    // Grass effect noise. Always seed 0, so moss looks the same in every
+    // world, as it always has.
+    noise_context_t effect_noise;
+
 //    actor_t * actors;
 //    int actor_array_capacity; // Total number of actors
 //    int num_actors; // Current array count
     array_t * actors;
     array_t * pending_actors;
 
+    // Handles find actors through these, see a_main.c.
+    array_t * actor_slots;
+    int free_actor_slot; // Head of the free slot list, or -1.
+
+    draw_list_t draw_list;
+    collision_index_t collision_index;
+    actor_residency_t residency;
+
 //    actor_t pending_actors[PENDING_ACTORS_MAX];
 //    int num_pending_actors;
     bool updating_actors;
@@ -59,7 +219,10 @@ typedef struct world {
 
     // debug:
     SDL_Texture * debug_map; // rendering of entire world, for debuggery
-    actor_t * player;
+    SDL_Color * debug_map_pixels; // debug_map's contents. NULL until shown.
+    // Chunks whose debug_map_pixels have changed since they were uploaded.
+    bool debug_map_dirty[WORLD_HEIGHT / CHUNK_SIZE][WORLD_WIDTH / CHUNK_SIZE];
+    actor_handle_t player;
 
     void (* draw)(tile_t * tile);
 } world_t;
@@ -79,15 +242,72 @@ void GetAdjacentTiles
     tile_t * world_tiles,
     tile_t * out[NUM_DIRECTIONS] );
 
+/// Bake grass effects from a fixed pool of variants, picked by a hash of the
+/// tile coordinate, instead of generating each tile's own.
+extern bool grass_effect_variants;
+
 void RenderWorld(world_t * world);
-void RenderGrassEffectTexture
-(   tile_t * tile,
-    tile_t ** adjacent_tiles,
-    int tile_x,
-    int tile_y );
+/// Draw a grass tile's effect (moss, flowers, and water edge highlights) into
+/// `surface`, a `TILE_SIZE` x `TILE_SIZE` `SDL_PIXELFORMAT_RGBA32` surface.
+/// Doesn't use the renderer, so it can run on any thread once the sprite
+/// sheet surfaces have been loaded. The result depends only on the arguments.
+/// - Parameter edges: `effect_edge_t` flags for sides to highlight.
+void RasterizeGrassEffect
+(   SDL_Surface * surface,
+    float noise_map[TILE_SIZE][TILE_SIZE],
+    u8 variety,
+    int edges,
+    rng_t * rng );
+
+/// Redraw a chunk's cached terrain, and its neighbors' adjoining edges, and
+/// its part of the debug map. Call when tiles in the chunk change.
+void InvalidateChunkTerrain(world_t * world, chunk_coord_t chunk);
+
+/// Redraw all cached chunk terrain, e.g. after changing how it's drawn.
+void InvalidateAllTerrain(world_t * world);
+
+/// Bytes of texture memory to keep baked chunk terrain in. Rounded down to
+/// whole terrain pages, minimum enough for every visible chunk. Read when a
+/// world is created.
+extern size_t terrain_cache_budget;
+
+/// Set up an empty terrain cache. Doesn't create any textures.
+void InitTerrainCache(world_t * world);
+void FreeTerrainCache(world_t * world);
+
+/// Keep the draw list in step with `world->actors`. See ActorsAppended()
+/// and ActorRemoving().
+void AddToDrawList(world_t * world, const actor_t * actor);
+void RemoveFromDrawList(world_t * world, const actor_t * actor);
+void FreeDrawList(world_t * world);
+void FreeCollisionIndex(world_t * world);
+void FreeActorResidency(world_t * world);
+
+/// Get the indices, in `world->actors` order, of actors in the chunks
+/// around `rect`, with a margin for sprites that reach outside their chunk.
+/// `out` is valid until the next call.
+int GetResidentsNear(world_t * world, SDL_Rect rect, int ** out);
+
+/// Call after appending `count` actors to `world->actors`.
+void ActorsAppended(world_t * world, int count);
+
+/// Call before removing the actor at `index` in `world->actors` by moving
+/// the last actor into its place.
+void ActorRemoving(world_t * world, int index);
 
 void DestroyWorld(world_t * world); // maybe FreeWorld would be more positive?
 
+/// Write the world's tiles and actors to a world file. See w_main.c for the
+/// format.
+void SaveWorld(world_t * world, const char * path);
+
+/// Check the actor contact grid against testing every pair, each tick.
+extern bool check_contacts;
+
+/// Find contacts among 1k, 5k, and 20k random hitboxes with the contact grid
+/// and by testing every pair, and print the times and any differences.
+void ContactBenchmark(void);
+
 /// Update world clock, lighting, tiles, and actors.
 void UpdateWorld
 (   world_t * world,
@@ -96,13 +316,80 @@ void UpdateWorld
 
 
 // TODO: move to debug.c
-void UpdateDebugMap(tile_t * tiles,  SDL_Texture ** debug_map, vec2_t camera);
+/// Bring the debug map texture up to date. Chunks' pixels are redrawn when
+/// their tiles change (see `InvalidateChunkTerrain()`), and only those
+/// chunks are uploaded here.
+void UpdateDebugMap(world_t * world);
+
+/// Save a one pixel per tile PNG of the world's terrain, in the debug map's
+/// colors.
+void SaveTerrainMap(tile_t * tiles, const char * path);
 
 // w_generation.c
 
+/// Queue a chunk for generation by a worker thread, if it isn't already
+/// loaded or generating.
 void LoadChunkIfNeeded(world_t * world, chunk_coord_t chunk_coord);
 void LoadChunkInRegion(world_t * world, position_t center, int tile_radius);
 
+/// Copy any chunks that workers have finished generating into the world and
+/// spawn their actors. Must be called from the main thread.
+void CommitGeneratedChunks(world_t * world);
+
+/// Block until all queued chunks have been generated, then commit them.
+void WaitForGeneratedChunks(world_t * world);
+
+void StopChunkWorkers(void);
+
+/// Queue the unloaded chunks that will scroll into view soonest, given
+/// the camera target and the player's velocity.
+void PrefetchChunks(world_t * world, vec2_t velocity);
+
+/// Generate every chunk of a new world on the calling thread, then again with
+/// the chunk workers, using 1, 2, 4, and 8 threads and shuffled queue order.
+/// Prints any chunk whose tiles or spawns differ from the single-threaded
+/// result. Runs without a window. Returns false if any chunk differed.
+bool CheckChunkGeneration(void);
+
+/// Generate the entire world without a window, using all worker threads.
+/// Writes `name`.world and a terrain map, `name`.png, and prints throughput
+/// and per-stage timings.
+void PregenerateWorld(const char * name);
+
+// w_tile.c
+
+/// Compute effect noise for the grass tiles in `chunk`. Replaces the previous
+/// chunk's noise.
+void ComputeChunkNoise(world_t * world, chunk_coord_t chunk);
+
+/// Compute effect noise for the pixels of the tile at tile_x, tile_y on its
+/// own, without a chunk's noise.
+void ComputeTileNoise
+(   world_t * world,
+    int tile_x,
+    int tile_y,
+    float out[TILE_SIZE][TILE_SIZE] );
+
+/// Get effect noise for the pixels of the tile at tile_x, tile_y, which must
+/// be a grass tile in the chunk last passed to `ComputeChunkNoise()`.
+void GetTileNoise(int tile_x, int tile_y, float out[TILE_SIZE][TILE_SIZE]);
+
+// w_island.c
+
+void InitIslands(world_t * world);
+
+/// Label the land in a newly committed chunk, joining it with islands in
+/// neighboring chunks.
+void LabelIslandsInChunk(world_t * world, chunk_coord_t chunk_coord);
+
+/// An ID for the island the tile at x, y is on, or -1 if it's not land or not
+/// loaded yet. IDs can change when more chunks are loaded.
+int GetIslandID(world_t * world, int x, int y);
+
+/// Number of loaded land tiles on the same island as the tile at x, y, or 0 if
+/// it's not land.
+int GetIslandArea(world_t * world, int x, int y);
+
 void PlayerUpdateCamera(actor_t * player, float dt);
 
 #endif /* world_h */